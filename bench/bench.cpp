@@ -0,0 +1,515 @@
+//////////////////////////////////////////////////////////////////////
+// bench.cpp -- Rendering benchmarks run on a pseudo-terminal
+// Date: Sun Oct 18 03:38:31 2026   (C) ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+
+#include <vector>
+
+#include <cppcurses/cppcurses.hpp>
+#include <cppcurses/logwin.hpp>
+#include <cppcurses/grid.hpp>
+
+#include "ptyterm.hpp"
+#include "counters.hpp"
+
+static const short rows = 60;
+static const short cols = 200;
+
+//////////////////////////////////////////////////////////////////////
+// A workload draws one frame per call; the harness refreshes
+//////////////////////////////////////////////////////////////////////
+
+struct Workload {
+	const char	*name;
+	void		(*setup)(Window *w);
+	void		(*frame)(Window *w,unsigned n);
+	void		(*teardown)(Window *w);
+};
+
+static std::vector<Window*> windows;
+static CppCurses *term = nullptr;
+
+static void
+no_setup(Window *w) {
+	w->erase();
+}
+
+static void
+del_windows(Window *w) {
+
+	for ( auto *win : windows )
+		delete win;
+	windows.clear();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Full screen of text, changing every frame
+//////////////////////////////////////////////////////////////////////
+
+static void
+fill_frame(Window *w,unsigned n) {
+	char line[cols+1];
+
+	for ( short y=0; y<rows; ++y ) {
+		for ( short x=0; x<cols; ++x )
+			line[x] = 'A' + (x + y + n) % 26;
+		line[cols] = 0;
+		w->move(y,0).addstr(line);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Many small mvprintf() calls: a dashboard of numeric fields
+//////////////////////////////////////////////////////////////////////
+
+static void
+mvprintf_frame(Window *w,unsigned n) {
+
+	for ( short y=0; y<rows; ++y )
+		for ( short x=0; x+10<=cols; x += 10 )
+			w->mvprintf(y,x,"%8u",n * 7919u + y * cols + x);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Create and destroy bordered popups
+//////////////////////////////////////////////////////////////////////
+
+static void
+border_frame(Window *w,unsigned n) {
+	for ( unsigned i=0; i<10; ++i ) {
+		short y = (n + i * 5) % (rows - 12);
+		short x = (n * 3 + i * 17) % (cols - 40);
+		Window *bw = w->border_window(y,x,12,40);
+
+		bw->mvprintf(1,1,"popup %u.%u",n,i);
+		delete bw;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// The same popups, through pooled WindowHandles
+//////////////////////////////////////////////////////////////////////
+
+static void
+pool_frame(Window *w,unsigned n) {
+	for ( unsigned i=0; i<10; ++i ) {
+		short y = (n + i * 5) % (rows - 12);
+		short x = (n * 3 + i * 17) % (cols - 40);
+		WindowHandle bw = w->make_border_window(y,x,12,40);
+
+		bw->mvprintf(1,1,"popup %u.%u",n,i);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Reorder a stack of overlapping panels
+//////////////////////////////////////////////////////////////////////
+
+static void
+panels_setup(Window *w) {
+
+	w->erase();
+	for ( unsigned i=0; i<20; ++i ) {
+		Window *pw = w->border_window(i * 2,i * 8,20,50);
+
+		pw->mvprintf(0,0,"panel %u",i);
+		windows.push_back(pw);
+	}
+}
+
+static void
+panels_frame(Window *w,unsigned n) {
+
+	windows[n % windows.size()]->top();
+	windows[(n * 7 + 3) % windows.size()]->bottom();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Hundreds of small panels, one of them drawn into per frame
+//////////////////////////////////////////////////////////////////////
+
+static void
+many_setup(Window *w) {
+
+	w->erase();
+	for ( unsigned i=0; i<400; ++i ) {
+		Window *pw = w->border_window((i * 7) % (rows - 6),(i * 13) % (cols - 20),6,20);
+
+		pw->mvprintf(0,0,"panel %u",i);
+		windows.push_back(pw);
+	}
+}
+
+static void
+many_frame(Window *w,unsigned n) {
+	Window *pw = windows[(n * 37) % windows.size()];
+
+	pw->mvprintf(1,0,"frame %u",n);
+	if ( n % 10 == 0 )
+		pw->top();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Colour switching through fg() and bg()
+//////////////////////////////////////////////////////////////////////
+
+static void
+colour_frame(Window *w,unsigned n) {
+
+	for ( short y=0; y<rows; y += 2 ) {
+		w->move(y,0);
+		for ( short x=0; x<cols; x += 2 ) {
+			w->fg(Colour((x + n) & 7)).bg(Colour((y + n + 1) & 7));
+			w->addch('#');
+		}
+	}
+	w->colour(Colour::White,Colour::Black);
+}
+
+//////////////////////////////////////////////////////////////////////
+// A log tailed at 100k lines/sec and 60 frames/sec: each frame adds
+// log_lines lines. "logscroll" scrolls and prints every line into a
+// window; "logwin" appends them to a LogWindow, which renders once.
+//////////////////////////////////////////////////////////////////////
+
+static const unsigned log_lines = 100000 / 60;
+static LogWindow *logw = nullptr;
+
+static void
+logscroll_frame(Window *w,unsigned n) {
+
+	for ( unsigned i=0; i<log_lines; ++i ) {
+		w->scroll(1);
+		w->mvprintf(rows-1,0,"%10u INFO request %u served in %u us",n * log_lines + i,i * 7919u,i % 977);
+	}
+}
+
+static void
+logwin_setup(Window *w) {
+
+	w->erase();
+	logw = new LogWindow(w,0,0,rows,cols,4096,1024*1024);
+}
+
+static void
+logwin_frame(Window *w,unsigned n) {
+
+	for ( unsigned i=0; i<log_lines; ++i )
+		logw->print("{:10} INFO request {} served in {} us",n * log_lines + i,i * 7919u,i % 977);
+	logw->render();
+}
+
+static void
+logwin_teardown(Window *w) {
+
+	delete logw;
+	logw = nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////
+// A table of 1M rows of 6 columns, scrolled down a row per frame with
+// 3 visible rows updated. "table" draws the visible rows with
+// mvprintf() per cell; "grid" uses a Grid.
+//////////////////////////////////////////////////////////////////////
+
+static const uint64_t table_rows = 1000000;
+static Grid *grid = nullptr;
+
+static void
+table_frame(Window *w,unsigned n) {
+
+	w->mvprintf(0,0,"%8s %-24s %10s %10s %8s %12s","PID","COMMAND","RSS","VSZ","CPU%","STATE");
+	for ( short y=1; y<rows; ++y ) {
+		uint64_t row = (n + y) % table_rows;
+		unsigned v = row % 20 == n % 20 ? n : 0;
+
+		w->mvprintf(y,0,"%8lu ",(unsigned long)row);
+		w->mvprintf(y,9,"%-24s ","process-name");
+		w->mvprintf(y,34,"%10lu ",(unsigned long)(row * 4096 + v));
+		w->mvprintf(y,45,"%10lu ",(unsigned long)(row * 8192));
+		w->mvprintf(y,56,"%8.1f ",(row % 1000) / 10.0);
+		w->mvprintf(y,65,"%12s","running");
+	}
+}
+
+static unsigned grid_frame_no = 0;
+
+static void
+grid_source(void *arg,uint64_t row,unsigned col,GridCell& cell) {
+	unsigned v = row % 20 == grid_frame_no % 20 ? grid_frame_no : 0;
+
+	switch ( col ) {
+	case 0:	cell.print("{}",row); break;
+	case 1:	cell.assign("process-name"); break;
+	case 2:	cell.print("{}",row * 4096 + v); break;
+	case 3:	cell.print("{}",row * 8192); break;
+	case 4:	cell.print("{:.1f}",(row % 1000) / 10.0); break;
+	default: cell.assign("running");
+	}
+}
+
+static void
+grid_setup(Window *w) {
+
+	w->erase();
+	grid = new Grid(w,0,0,rows,cols,{
+		{ "PID", 8, true }, { "COMMAND", 24 }, { "RSS", 10, true },
+		{ "VSZ", 10, true }, { "CPU%", 8, true }, { "STATE", 12, true } },
+		grid_source,nullptr);
+	grid->rows(table_rows);
+}
+
+static void
+grid_frame(Window *w,unsigned n) {
+
+	grid_frame_no = n;
+	grid->scroll_to(n % table_rows);
+	for ( uint64_t row=grid->first_row(); row<grid->first_row()+uint64_t(rows); ++row )
+		if ( row % 20 == n % 20 || row % 20 == (n + 19) % 20 )
+			grid->invalidate(row);		// Changed, or changed back
+	grid->render();
+}
+
+static void
+grid_teardown(Window *w) {
+
+	delete grid;
+	grid = nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////
+// A window drag: 8 terminal resizes per frame, coalesced into one
+// relayout of a log pane, a bordered pane reaching to the edges and
+// a status line placed by its on_resize() function
+//////////////////////////////////////////////////////////////////////
+
+static void
+status_resize(void *arg,Window& sw,short nrows,short ncols) {
+
+	sw.move_window(nrows-1,0).resize(1,ncols);
+	sw.erase().mvprintf(0,0,"%d x %d",ncols,nrows);
+}
+
+static void
+resize_setup(Window *w) {
+
+	w->erase();
+	logw = new LogWindow(w,0,0,0,cols/2,4096,1024*1024,true);
+	for ( unsigned i=0; i<500; ++i )
+		logw->print("{:10} INFO request {} served",i,i * 7919u);
+	windows.push_back(w->border_window(0,cols/2,0,0));
+	windows.back()->mvprintf(0,0,"pane");
+	windows.push_back(w->new_window(rows-1,0,1,cols));
+	windows.back()->on_resize(status_resize);
+}
+
+static void
+resize_frame(Window *w,unsigned n) {
+
+	term->begin_frame();
+	for ( unsigned i=0; i<8; ++i ) {
+		unsigned d = (n * 8 + i) % 40;
+
+		term->resize(rows - d / 2,cols - d);
+	}
+	term->end_frame();
+	logw->render();
+}
+
+static void
+resize_teardown(Window *w) {
+
+	delete logw;
+	logw = nullptr;
+	del_windows(w);
+	term->resize(rows,cols);
+}
+
+static const Workload workloads[] = {
+	{ "fill",	no_setup,	fill_frame,	nullptr },
+	{ "mvprintf",	no_setup,	mvprintf_frame,	nullptr },
+	{ "border",	no_setup,	border_frame,	nullptr },
+	{ "pool",	no_setup,	pool_frame,	nullptr },
+	{ "panels",	panels_setup,	panels_frame,	del_windows },
+	{ "many",	many_setup,	many_frame,	del_windows },
+	{ "colour",	no_setup,	colour_frame,	nullptr },
+	{ "logscroll",	no_setup,	logscroll_frame, nullptr },
+	{ "logwin",	logwin_setup,	logwin_frame,	logwin_teardown },
+	{ "table",	no_setup,	table_frame,	nullptr },
+	{ "grid",	grid_setup,	grid_frame,	grid_teardown },
+	{ "resize",	resize_setup,	resize_frame,	resize_teardown },
+};
+
+static double
+now() {
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Wait until the terminal output has been drained
+//////////////////////////////////////////////////////////////////////
+
+static void
+settle(PtyTerm& pty) {
+	uint64_t bytes;
+
+	do	{
+		bytes = pty.bytes();
+		usleep(30000);
+	} while ( pty.bytes() != bytes );
+}
+
+static void
+usage(const char *cmd) {
+	fprintf(stderr,"Usage: %s [-n frames] [-l label] [-w workload] [-t] [-a] [-d] [-s|-S]\n"
+		"\t-n\tFrames per workload (200)\n"
+		"\t-l\tLabel written to each result (\"\")\n"
+		"\t-w\tRun only the named workload\n"
+		"\t-t\tText table, instead of JSON lines\n"
+		"\t-a\tAlso report the library's output accounting\n"
+		"\t-d\tUpdate with the library's diffing renderer, not doupdate()\n"
+		"\t-s\tOne write() per frame\n"
+		"\t-S\tOne write() per frame, with synchronized updates (DEC 2026)\n",
+		cmd);
+	exit(2);
+}
+
+int
+main(int argc,char **argv) {
+	unsigned nframes = 200;
+	const char *label = "";
+	const char *only = nullptr;
+	bool textf = false, accountf = false, difff = false, singlef = false;
+	CppCurses::Sync sync = CppCurses::Sync::Off;
+	int optch;
+
+	while ( (optch = getopt(argc,argv,"n:l:w:tadsSh")) != -1 ) {
+		switch ( optch ) {
+		case 'n':
+			nframes = strtoul(optarg,nullptr,10);
+			break;
+		case 'l':
+			label = optarg;
+			break;
+		case 'w':
+			only = optarg;
+			break;
+		case 't':
+			textf = true;
+			break;
+		case 'a':
+			accountf = true;
+			break;
+		case 'd':
+			difff = true;
+			break;
+		case 'S':
+			sync = CppCurses::Sync::On;
+			/* Fall thru */
+		case 's':
+			singlef = true;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if ( !nframes )
+		usage(argv[0]);
+
+	PtyTerm pty(rows,cols);
+	CppCurses curses;
+	Window *w = curses.open();
+
+	term = &curses;
+	int out = pty.out();
+
+	curses.account_output(accountf);
+	curses.diff_render(difff);
+	curses.single_write(singlef,sync);
+
+	if ( textf )
+		dprintf(out,"%-10s %10s %12s %10s %10s %10s %10s\n",
+			"workload","fps","bytes/frm","sys/frm","wr/frm","rd/frm","alloc/frm");
+
+	for ( auto& wl : workloads ) {
+		if ( only && strcmp(only,wl.name) != 0 )
+			continue;
+
+		wl.setup(w);
+		for ( unsigned n=0; n<5; ++n ) {		// Warm up
+			wl.frame(w,n);
+			w->refresh();
+		}
+		settle(pty);
+
+		uint64_t bytes0 = pty.bytes(), reads0 = pty.reads();
+		CppCurses::Stats s0 = curses.stats();
+		Counters c0 = counters::get();
+		double t0 = now();
+
+		counters::enable(true);
+		for ( unsigned n=0; n<nframes; ++n ) {
+			wl.frame(w,n);
+			w->refresh();
+		}
+		counters::enable(false);
+
+		double secs = now() - t0;
+		Counters c = counters::get() - c0;
+
+		settle(pty);
+		double bytes = double(pty.bytes() - bytes0);
+		double reads = double(pty.reads() - reads0);
+		const CppCurses::Stats& s = curses.stats();
+		unsigned long updates = s.updates - s0.updates;
+
+		if ( textf ) {
+			dprintf(out,"%-10s %10.1f %12.1f %10.2f %10.2f %10.2f %10.2f\n",
+				wl.name,nframes / secs,bytes / nframes,
+				double(c.syscalls) / nframes,
+				double(c.writes) / nframes,
+				reads / nframes,
+				double(c.allocs) / nframes);
+			if ( accountf && updates > 0 )
+				dprintf(out,"%-10s %10s %12.1f %10s %10.2f %10s  (library, %.1f us flush/update)\n",
+					"","",double(s.out_bytes - s0.out_bytes) / updates,"",
+					double(s.out_writes - s0.out_writes) / updates,"",
+					double(s.flush_ns - s0.flush_ns) / updates / 1e3);
+		} else	{
+			dprintf(out,"{\"label\":\"%s\",\"workload\":\"%s\",\"rows\":%d,\"cols\":%d,"
+				"\"frames\":%u,\"seconds\":%.6f,\"fps\":%.2f,\"bytes_per_frame\":%.1f,"
+				"\"syscalls_per_frame\":%.3f,\"writes_per_frame\":%.3f,\"reads_per_frame\":%.3f,"
+				"\"allocs_per_frame\":%.3f,\"alloc_bytes_per_frame\":%.1f}\n",
+				label,wl.name,rows,cols,nframes,secs,nframes / secs,bytes / nframes,
+				double(c.syscalls) / nframes,
+				double(c.writes) / nframes,
+				reads / nframes,
+				double(c.allocs) / nframes,
+				double(c.alloc_bytes) / nframes);
+			if ( accountf && updates > 0 )
+				dprintf(out,"{\"label\":\"%s\",\"workload\":\"%s\",\"updates\":%lu,"
+					"\"out_bytes_per_update\":%.1f,\"out_writes_per_update\":%.3f,"
+					"\"flush_us_per_update\":%.2f}\n",
+					label,wl.name,updates,
+					double(s.out_bytes - s0.out_bytes) / updates,
+					double(s.out_writes - s0.out_writes) / updates,
+					double(s.flush_ns - s0.flush_ns) / updates / 1e3);
+		}
+		if ( wl.teardown )
+			wl.teardown(w);
+	}
+
+	curses.close();
+	return 0;
+}
+
+// End bench.cpp
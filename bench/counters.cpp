@@ -0,0 +1,179 @@
+//////////////////////////////////////////////////////////////////////
+// counters.cpp -- Benchmark syscall and allocation counters
+// Date: Sun Oct 18 03:38:31 2026   (C) ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <sys/select.h>
+#include <sys/epoll.h>
+
+#include <atomic>
+
+#include "counters.hpp"
+
+extern "C" {
+	void *__libc_malloc(size_t size);
+	void *__libc_calloc(size_t nmemb,size_t size);
+	void *__libc_realloc(void *ptr,size_t size);
+}
+
+static thread_local bool countf = false;
+
+static std::atomic<uint64_t> n_syscalls{0};
+static std::atomic<uint64_t> n_writes{0};
+static std::atomic<uint64_t> n_allocs{0};
+static std::atomic<uint64_t> n_alloc_bytes{0};
+
+Counters
+Counters::operator-(const Counters& other) const {
+	Counters r;
+
+	r.syscalls = syscalls - other.syscalls;
+	r.writes = writes - other.writes;
+	r.allocs = allocs - other.allocs;
+	r.alloc_bytes = alloc_bytes - other.alloc_bytes;
+	return r;
+}
+
+void
+counters::enable(bool on) {
+	countf = on;
+}
+
+Counters
+counters::get() {
+	Counters c;
+
+	c.syscalls = n_syscalls.load();
+	c.writes = n_writes.load();
+	c.allocs = n_allocs.load();
+	c.alloc_bytes = n_alloc_bytes.load();
+	return c;
+}
+
+static inline void
+count_syscall(bool writef=false) {
+
+	if ( countf ) {
+		n_syscalls.fetch_add(1,std::memory_order_relaxed);
+		if ( writef )
+			n_writes.fetch_add(1,std::memory_order_relaxed);
+	}
+}
+
+static inline void
+count_alloc(size_t bytes) {
+
+	if ( countf ) {
+		n_allocs.fetch_add(1,std::memory_order_relaxed);
+		n_alloc_bytes.fetch_add(bytes,std::memory_order_relaxed);
+	}
+}
+
+template <typename F>
+static inline F
+next(F& fp,const char *name) {
+
+	if ( !fp )
+		fp = F(dlsym(RTLD_NEXT,name));
+	return fp;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Interposed entry points
+//////////////////////////////////////////////////////////////////////
+
+extern "C" {
+
+void *
+malloc(size_t size) {
+	count_alloc(size);
+	return __libc_malloc(size);
+}
+
+void *
+calloc(size_t nmemb,size_t size) {
+	count_alloc(nmemb * size);
+	return __libc_calloc(nmemb,size);
+}
+
+void *
+realloc(void *ptr,size_t size) {
+	count_alloc(size);
+	return __libc_realloc(ptr,size);
+}
+
+ssize_t
+write(int fd,const void *buf,size_t count) {
+	static ssize_t (*fp)(int,const void *,size_t) = nullptr;
+
+	count_syscall(true);
+	return next(fp,"write")(fd,buf,count);
+}
+
+ssize_t
+writev(int fd,const struct iovec *iov,int iovcnt) {
+	static ssize_t (*fp)(int,const struct iovec *,int) = nullptr;
+
+	count_syscall(true);
+	return next(fp,"writev")(fd,iov,iovcnt);
+}
+
+ssize_t
+read(int fd,void *buf,size_t count) {
+	static ssize_t (*fp)(int,void *,size_t) = nullptr;
+
+	count_syscall();
+	return next(fp,"read")(fd,buf,count);
+}
+
+int
+poll(struct pollfd *fds,nfds_t nfds,int timeout) {
+	static int (*fp)(struct pollfd *,nfds_t,int) = nullptr;
+
+	count_syscall();
+	return next(fp,"poll")(fds,nfds,timeout);
+}
+
+int
+select(int nfds,fd_set *rfds,fd_set *wfds,fd_set *efds,struct timeval *tv) {
+	static int (*fp)(int,fd_set *,fd_set *,fd_set *,struct timeval *) = nullptr;
+
+	count_syscall();
+	return next(fp,"select")(nfds,rfds,wfds,efds,tv);
+}
+
+int
+epoll_wait(int epfd,struct epoll_event *events,int maxevents,int timeout) {
+	static int (*fp)(int,struct epoll_event *,int,int) = nullptr;
+
+	count_syscall();
+	return next(fp,"epoll_wait")(epfd,events,maxevents,timeout);
+}
+
+int
+ioctl(int fd,unsigned long request,...) {
+	static int (*fp)(int,unsigned long,void *) = nullptr;
+	va_list ap;
+	void *arg;
+
+	va_start(ap,request);
+	arg = va_arg(ap,void *);
+	va_end(ap);
+	count_syscall();
+	return next(fp,"ioctl")(fd,request,arg);
+}
+
+} // extern "C"
+
+// End counters.cpp
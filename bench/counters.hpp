@@ -0,0 +1,36 @@
+//////////////////////////////////////////////////////////////////////
+// counters.hpp -- Benchmark syscall and allocation counters
+// Date: Sun Oct 18 03:38:31 2026   (C) ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#ifndef COUNTERS_HPP
+#define COUNTERS_HPP
+
+#include <stdint.h>
+
+//////////////////////////////////////////////////////////////////////
+// The benchmark executable interposes the libc entry points below,
+// counting the calls made by threads that have enabled counting
+// (so that the pty drain thread is not counted). Counted syscalls
+// are write, writev, read, poll, select, epoll_wait and ioctl;
+// allocations are malloc, calloc and realloc (operator new uses
+// malloc).
+//////////////////////////////////////////////////////////////////////
+
+struct Counters {
+	uint64_t	syscalls = 0;	// All counted syscalls
+	uint64_t	writes = 0;	// write() and writev() only
+	uint64_t	allocs = 0;	// Allocation calls
+	uint64_t	alloc_bytes = 0; // Bytes requested
+
+	Counters operator-(const Counters& other) const;
+};
+
+namespace counters {
+	void enable(bool on);		// Count calls made by this thread
+	Counters get();
+}
+
+#endif // COUNTERS_HPP
+
+// End counters.hpp
@@ -0,0 +1,354 @@
+//////////////////////////////////////////////////////////////////////
+// micro.cpp -- Per call microbenchmarks, run on a headless screen
+// Date: Sun Oct 18 03:39:46 2026   (C) ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+
+#include <cppcurses/cppcurses.hpp>
+#include <cppcurses/layout.hpp>
+
+#include <curses.h>			// For ungetch()
+
+#undef getch
+#undef attr_on
+#undef attr_off
+#undef addch
+#undef addstr
+
+//////////////////////////////////////////////////////////////////////
+// Each microbenchmark performs n calls of the measured operation
+//////////////////////////////////////////////////////////////////////
+
+struct Micro {
+	const char	*name;
+	void		(*run)(Window *w,unsigned n);
+};
+
+static void
+micro_addgrstr(Window *w,unsigned n) {
+
+	for ( unsigned i=0; i<n; ++i ) {
+		if ( i % 8 == 0 )
+			w->move(i / 8 % 50,0);
+		w->addgrstr("L--T--R|");
+	}
+}
+
+static void
+micro_attr_on(Window *w,unsigned n) {
+
+	for ( unsigned i=0; i<n; ++i ) {
+		w->attr_on("BR");
+		w->attr_off("BR");
+	}
+}
+
+static void
+micro_attr_lit(Window *w,unsigned n) {
+
+	for ( unsigned i=0; i<n; ++i ) {
+		w->attr_on("BR"_attr);
+		w->attr_off("BR"_attr);
+	}
+}
+
+static void
+micro_style(Window *w,unsigned n) {
+	static constexpr Style styles[2] = {
+		Style("BR"_attr,Colour::Yellow,Colour::Red),
+		Style("U"_attr,Colour::White,Colour::Blue),
+	};
+
+	for ( unsigned i=0; i<n; ++i )
+		w->style(styles[i & 1]);
+}
+
+static void
+micro_colour(Window *w,unsigned n) {
+
+	for ( unsigned i=0; i<n; ++i ) {
+		w->fg(Colour(i & 7));
+		w->bg(Colour((i >> 3) & 7));
+	}
+}
+
+static void
+micro_colour256(Window *w,unsigned n) {
+
+	for ( unsigned i=0; i<n; ++i )
+		w->colour(int(16 + (i & 15)),int(232 + (i >> 4 & 15)));
+}
+
+static void
+micro_rgb(Window *w,unsigned n) {
+
+	for ( unsigned i=0; i<n; ++i )
+		w->colour(Rgb(i & 0xFF,0x80,0x40),Rgb(0,0,i >> 8 & 0xFF));
+}
+
+static void
+micro_printf(Window *w,unsigned n) {
+
+	for ( unsigned i=0; i<n; ++i )
+		w->mvprintf(i % 50,0,"%-10s %6u %8.2f",(i & 1) ? "odd" : "even",i,i * 0.25);
+}
+
+static void
+micro_print(Window *w,unsigned n) {
+
+	for ( unsigned i=0; i<n; ++i )
+		w->mvprint(i % 50,0,"{:<10} {:6} {:8.2f}",(i & 1) ? "odd" : "even",i,i * 0.25);
+}
+
+static void
+micro_row_calls(Window *w,unsigned n) {
+	static constexpr Style styles[2] = {
+		Style("B"_attr,Colour::Yellow,Colour::Blue),
+		Style("R"_attr,Colour::Green,Colour::Black),
+	};
+
+	for ( unsigned i=0; i<n; ++i ) {
+		w->move(i % 50,0);
+		for ( unsigned x=0; x<80; ++x )
+			w->style(styles[x >> 3 & 1]).addch('a' + x % 26);
+	}
+}
+
+static void
+micro_row_blit(Window *w,unsigned n) {
+	static constexpr Style styles[2] = {
+		Style("B"_attr,Colour::Yellow,Colour::Blue),
+		Style("R"_attr,Colour::Green,Colour::Black),
+	};
+	Cell row[80];
+
+	for ( unsigned i=0; i<n; ++i ) {
+		for ( unsigned x=0; x<80; ++x )
+			row[x] = Cell('a' + x % 26,styles[x >> 3 & 1]);
+		w->blit(i % 50,0,row);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Text throughput: 70 column lines of ASCII, and of CJK (35 double
+// width characters), through addstr() and through plain waddnstr()
+//////////////////////////////////////////////////////////////////////
+
+static const char ascii_line[] =
+	"The quick brown fox jumps over the lazy dog; 0123456789 ABCDEFGHIJKLMN";
+static const char cjk_line[] =
+	"\u65e5\u672c\u8a9e\u306e\u30c6\u30ad\u30b9\u30c8\u3068\u4e2d\u6587\u6587\u672c"
+	"\u65e5\u672c\u8a9e\u306e\u30c6\u30ad\u30b9\u30c8\u3068\u4e2d\u6587\u6587\u672c"
+	"\u65e5\u672c\u8a9e\u306e\u30c6\u30ad\u30b9\u30c8\u3068";
+
+static void
+micro_text_ascii(Window *w,unsigned n) {
+
+	for ( unsigned i=0; i<n; ++i )
+		w->move(i % 50,0).addstr(std::string_view(ascii_line,sizeof ascii_line - 1));
+}
+
+static void
+micro_raw_ascii(Window *w,unsigned n) {
+
+	for ( unsigned i=0; i<n; ++i ) {
+		w->move(i % 50,0);
+		waddnstr(stdscr,ascii_line,sizeof ascii_line - 1);
+	}
+}
+
+static void
+micro_text_cjk(Window *w,unsigned n) {
+
+	for ( unsigned i=0; i<n; ++i )
+		w->move(i % 50,0).addstr(std::string_view(cjk_line,sizeof cjk_line - 1));
+}
+
+static void
+micro_raw_cjk(Window *w,unsigned n) {
+
+	for ( unsigned i=0; i<n; ++i ) {
+		w->move(i % 50,0);
+		waddnstr(stdscr,cjk_line,sizeof cjk_line - 1);
+	}
+}
+
+static void
+micro_getch(Window *w,unsigned n) {
+	static const int keys[] = { KEY_UP, KEY_DOWN, KEY_F(5), 'x', KEY_NPAGE, KEY_HOME, KEY_BTAB, KEY_RESIZE };
+
+	for ( unsigned i=0; i<n; ++i ) {
+		ungetch(keys[i & 7]);
+		w->getch();
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Border windows of 12x40, made and dropped within one frame (so
+// that no screen update is measured): newly made each time, or taken
+// from the pool
+//////////////////////////////////////////////////////////////////////
+
+static CppCurses *term = nullptr;
+
+static void
+micro_border_new(Window *w,unsigned n) {
+
+	term->begin_frame();
+	for ( unsigned i=0; i<n; ++i ) {
+		Window *bw = w->border_window(i % 40,i % 150,12,40);
+
+		delete bw;
+	}
+	term->end_frame();
+}
+
+static void
+micro_border_pool(Window *w,unsigned n) {
+
+	term->begin_frame();
+	for ( unsigned i=0; i<n; ++i )
+		WindowHandle bw = w->make_border_window(i % 40,i % 150,12,40);
+	term->end_frame();
+}
+
+//////////////////////////////////////////////////////////////////////
+// A layout of 501 nodes: 10 columns of 7 rows of 6 panes, with fixed,
+// shared and limited sizes (no windows: the layout pass alone)
+//////////////////////////////////////////////////////////////////////
+
+static Layout
+build_layout() {
+	Layout lay(Layout::Split::Columns);
+
+	for ( unsigned c=0; c<10; ++c ) {
+		Layout::Node col = lay.add(lay.root(),c == 0 ? Layout::fixed(24) : Layout::flex(c % 3 + 1,8));
+
+		for ( unsigned r=0; r<7; ++r ) {
+			Layout::Node row = lay.add(col,r == 0 ? Layout::fixed(3) : Layout::flex(1,2,12),Layout::Split::Columns);
+
+			for ( unsigned p=0; p<6; ++p )
+				lay.add(row,p & 1 ? Layout::fixed(5) : Layout::flex(2,1));
+		}
+	}
+	lay.apply(60,200);
+	return lay;
+}
+
+static Layout&
+the_layout() {
+	static Layout layout = build_layout();	// Shared by both micros
+
+	return layout;
+}
+
+static void
+micro_layout_full(Window *w,unsigned n) {
+	Layout& layout = the_layout();
+
+	for ( unsigned i=0; i<n; ++i )
+		layout.apply(60 + (i & 1),200 + (i & 1));
+}
+
+static void
+micro_layout_one(Window *w,unsigned n) {
+	Layout& layout = the_layout();
+
+	for ( unsigned i=0; i<n; ++i ) {
+		layout.size(layout.nodes() - 1,Layout::flex(2 + (i & 1),1));
+		layout.apply(60,200);
+	}
+}
+
+static const Micro micros[] = {
+	{ "addgrstr",	micro_addgrstr },	// ns per 8 char string
+	{ "attr_on",	micro_attr_on },	// ns per attr_on()+attr_off()
+	{ "attr_lit",	micro_attr_lit },	// ns per attr_on()+attr_off() with "BR"_attr
+	{ "style",	micro_style },		// ns per style()
+	{ "fg_bg",	micro_colour },		// ns per fg()+bg()
+	{ "colour256",	micro_colour256 },	// ns per colour(int,int), cached pair
+	{ "rgb",	micro_rgb },		// ns per colour(Rgb,Rgb)
+	{ "printf",	micro_printf },		// ns per mvprintf() of 3 fields
+	{ "print",	micro_print },		// ns per mvprint() of the same
+	{ "row_calls",	micro_row_calls },	// ns per 80 cell row, style()+addch()
+	{ "row_blit",	micro_row_blit },	// ns per 80 cell row, built and blit()
+	{ "text_ascii",	micro_text_ascii },	// ns per 70 column ASCII line, addstr()
+	{ "raw_ascii",	micro_raw_ascii },	// ns per the same, waddnstr()
+	{ "text_cjk",	micro_text_cjk },	// ns per 70 column CJK line, addstr()
+	{ "raw_cjk",	micro_raw_cjk },	// ns per the same, waddnstr()
+	{ "getch",	micro_getch },		// ns per key translated
+	{ "border_new",	micro_border_new },	// ns per border_window() made and deleted
+	{ "border_pool", micro_border_pool },	// ns per make_border_window() from the pool
+	{ "layout_all",	micro_layout_full },	// ns per layout pass, 501 nodes, all resized
+	{ "layout_one",	micro_layout_one },	// ns per layout pass, one pane resized
+};
+
+static double
+now() {
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int
+main(int argc,char **argv) {
+	unsigned n = 1000000;
+	const char *label = "";
+	bool textf = false;
+	int optch;
+
+	while ( (optch = getopt(argc,argv,"n:l:th")) != -1 ) {
+		switch ( optch ) {
+		case 'n':
+			n = strtoul(optarg,nullptr,10);
+			break;
+		case 'l':
+			label = optarg;
+			break;
+		case 't':
+			textf = true;
+			break;
+		default:
+			fprintf(stderr,"Usage: %s [-n calls] [-l label] [-t]\n",argv[0]);
+			exit(2);
+		}
+	}
+
+	CppCurses curses;
+	Window *w = curses.open_headless(60,200);
+	double results[sizeof micros / sizeof micros[0]];
+	unsigned x = 0;
+
+	if ( !w ) {
+		fprintf(stderr,"Unable to open a headless screen\n");
+		return 1;
+	}
+	term = &curses;
+
+	for ( auto& m : micros ) {
+		double t0;
+
+		m.run(w,n / 10);		// Warm up
+		t0 = now();
+		m.run(w,n);
+		results[x++] = (now() - t0) * 1e9 / n;
+	}
+	curses.close();
+
+	x = 0;
+	for ( auto& m : micros ) {
+		if ( textf )
+			printf("%-10s %10.1f ns/call\n",m.name,results[x++]);
+		else	printf("{\"label\":\"%s\",\"micro\":\"%s\",\"calls\":%u,\"ns_per_call\":%.2f}\n",
+				label,m.name,n,results[x++]);
+	}
+	return 0;
+}
+
+// End micro.cpp
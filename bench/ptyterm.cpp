@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////
+// ptyterm.cpp -- Benchmark pseudo-terminal
+// Date: Sun Oct 18 03:35:32 2026   (C) ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <assert.h>
+#include <poll.h>
+#include <pty.h>
+#include <sys/ioctl.h>
+
+#include "ptyterm.hpp"
+
+PtyTerm::PtyTerm(unsigned short rows,unsigned short cols) {
+	winsize ws;
+	int rc;
+
+	memset(&ws,0,sizeof ws);
+	ws.ws_row = rows;
+	ws.ws_col = cols;
+	rc = openpty(&master,&slave,nullptr,nullptr,&ws);
+	assert(!rc);
+
+	if ( !getenv("TERM") )
+		setenv("TERM","xterm-256color",1);
+
+	fflush(stdout);
+	savedin = dup(0);
+	savedout = dup(1);
+	dup2(slave,0);
+	dup2(slave,1);
+
+	drainer = std::thread(&PtyTerm::drain,this);
+}
+
+PtyTerm::~PtyTerm() {
+
+	fflush(stdout);
+	stopf = true;
+	drainer.join();
+	dup2(savedin,0);
+	dup2(savedout,1);
+	::close(savedin);
+	::close(savedout);
+	::close(slave);
+	::close(master);
+}
+
+void
+PtyTerm::drain() {
+	char buf[65536];
+	pollfd pfd;
+	ssize_t n;
+
+	pfd.fd = master;
+	pfd.events = POLLIN;
+
+	while ( !stopf ) {
+		pfd.revents = 0;
+		if ( poll(&pfd,1,20) <= 0 )
+			continue;
+		n = read(master,buf,sizeof buf);
+		if ( n > 0 ) {
+			nbytes += n;
+			++nreads;
+		}
+		else if ( n < 0 && errno != EINTR && errno != EAGAIN )
+			break;
+	}
+}
+
+void
+PtyTerm::keys(const char *str,size_t n) {
+
+	while ( n > 0 ) {
+		ssize_t rc = write(master,str,n);
+		if ( rc < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			break;
+		}
+		str += rc;
+		n -= rc;
+	}
+}
+
+// End ptyterm.cpp
@@ -0,0 +1,46 @@
+//////////////////////////////////////////////////////////////////////
+// ptyterm.hpp -- Benchmark pseudo-terminal
+// Date: Sun Oct 18 03:35:32 2026   (C) ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#ifndef PTYTERM_HPP
+#define PTYTERM_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atomic>
+#include <thread>
+
+//////////////////////////////////////////////////////////////////////
+// Places a pty on stdin/stdout, so that CppCurses::open() drives it
+// like a real terminal. The master side is drained on a thread,
+// counting the bytes the library writes, and the reads they took (a
+// frame that arrives in pieces can be shown torn). Reports go to
+// out().
+//////////////////////////////////////////////////////////////////////
+
+class PtyTerm {
+	int			master = -1;
+	int			slave = -1;
+	int			savedin = -1;
+	int			savedout = -1;
+	std::thread		drainer;
+	std::atomic<bool>	stopf{false};
+	std::atomic<uint64_t>	nbytes{0};
+	std::atomic<uint64_t>	nreads{0};	// Chunks the terminal saw
+
+	void drain();
+
+public:	PtyTerm(unsigned short rows=60,unsigned short cols=200);
+	~PtyTerm();
+
+	void keys(const char *str,size_t n);	// Type keys into the terminal
+	uint64_t bytes() const { return nbytes.load(); }
+	uint64_t reads() const { return nreads.load(); }
+	int out() const { return savedout; }	// Original stdout
+};
+
+#endif // PTYTERM_HPP
+
+// End ptyterm.hpp
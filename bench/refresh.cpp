@@ -0,0 +1,63 @@
+//////////////////////////////////////////////////////////////////////
+// refresh.cpp -- Screen updates per 1,000 keystrokes
+// Date: Sun Oct 18 03:35:32 2026   (C) ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include <cppcurses/cppcurses.hpp>
+
+#include "ptyterm.hpp"
+
+static const unsigned nkeys = 1000;
+
+//////////////////////////////////////////////////////////////////////
+// Type nkeys keys and read them back, drawing on every draw_every
+// keystroke (0 never). When forcef is true, the screen is refreshed
+// before every read, which is what getch() and readch() used to do.
+//////////////////////////////////////////////////////////////////////
+
+static void
+run(PtyTerm& pty,CppCurses& curses,Window *w,const char *name,bool forcef,unsigned draw_every) {
+	std::string keys(nkeys,'k');
+	unsigned long updates0 = curses.stats().updates;
+	uint64_t bytes0 = pty.bytes();
+	unsigned n = 0;
+
+	pty.keys(keys.data(),keys.size());
+
+	while ( n < nkeys ) {
+		if ( draw_every && n % draw_every == 0 )
+			w->mvprintf(1,1,"key %u",n);
+		if ( forcef )
+			w->refresh();
+		if ( w->readch_for(1000) == -1 )
+			break;
+		++n;
+	}
+
+	dprintf(pty.out(),"%-28s keys %5u updates %5lu bytes %8llu\n",
+		name,n,
+		curses.stats().updates - updates0,
+		(unsigned long long)(pty.bytes() - bytes0));
+}
+
+int
+main(int argc,char **argv) {
+	PtyTerm pty;
+	CppCurses curses;
+	Window *w = curses.open();
+
+	w->refresh();
+	run(pty,curses,w,"refresh per read (before)",true,0);
+	run(pty,curses,w,"idle reads (after)",false,0);
+	run(pty,curses,w,"draw every 10th (after)",false,10);
+	curses.close();
+	return 0;
+}
+
+// End refresh.cpp
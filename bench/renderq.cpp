@@ -0,0 +1,238 @@
+//////////////////////////////////////////////////////////////////////
+// renderq.cpp -- Worker threads drawing through a RenderQueue,
+// compared with a mutex held around each draw call
+// Date: Sun Oct 18 03:57:55 2026   (C) ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cppcurses/cppcurses.hpp>
+#include <cppcurses/renderq.hpp>
+
+static unsigned nthreads = 16;		// Producer threads
+static unsigned nposts = 20000;		// Draw calls per producer
+static unsigned burst = 32;		// Draw calls between pauses
+static unsigned pause_us = 2000;	// Pause between bursts
+
+static double
+now() {
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+nap() {
+	timespec ts = { 0, long(pause_us) * 1000 };
+
+	nanosleep(&ts,nullptr);
+}
+
+struct Result {
+	const char	*mode;
+	double		ns_per_post;	// Producer side cost
+	double		secs;		// Wall time
+	uint64_t	posted;
+	uint64_t	dropped;
+	uint64_t	updates;	// Screen updates
+};
+
+//////////////////////////////////////////////////////////////////////
+// Each producer owns a row, and draws a counter into it. The render
+// thread applies the queue (and updates the screen) every 1 ms.
+//////////////////////////////////////////////////////////////////////
+
+static Result
+run_queue(CppCurses& curses,Window *w) {
+	RenderQueue q(curses,1024);
+	std::atomic<unsigned> running{nthreads};
+	std::atomic<uint64_t> post_ns{0};
+	std::vector<std::thread> threads;
+	uint64_t updates = curses.stats().updates;
+	double t0 = now();
+
+	for ( unsigned t=0; t<nthreads; ++t )
+		threads.emplace_back([&,t]() {
+			double busy = 0;
+
+			for ( unsigned i=0; i<nposts; ) {
+				double b0 = now();
+
+				for ( unsigned k=0; k<burst && i<nposts; ++k, ++i )
+					q.mvprint(w,short(t),0,"worker {:2} count {:8} {:>6.1f}%",t,i,i * 100.0 / nposts);
+				busy += now() - b0;
+				nap();
+			}
+			post_ns += uint64_t(busy * 1e9);
+			--running;
+		});
+
+	while ( running > 0 ) {
+		q.render();
+		usleep(1000);
+	}
+	q.render();
+
+	double secs = now() - t0;
+
+	for ( auto& th : threads )
+		th.join();
+
+	RenderQueue::Stats st = q.stats();
+
+	return Result{ "queue", double(post_ns) / (double(nthreads) * nposts), secs,
+		st.posted, st.dropped, curses.stats().updates - updates };
+}
+
+//////////////////////////////////////////////////////////////////////
+// The same, with every draw call (and the refresh) under one mutex
+//////////////////////////////////////////////////////////////////////
+
+static Result
+run_mutex(CppCurses& curses,Window *w) {
+	std::mutex mutex;
+	std::atomic<unsigned> running{nthreads};
+	std::atomic<uint64_t> post_ns{0};
+	std::vector<std::thread> threads;
+	uint64_t updates = curses.stats().updates;
+	double t0 = now();
+
+	for ( unsigned t=0; t<nthreads; ++t )
+		threads.emplace_back([&,t]() {
+			double busy = 0;
+
+			for ( unsigned i=0; i<nposts; ) {
+				double b0 = now();
+
+				for ( unsigned k=0; k<burst && i<nposts; ++k, ++i ) {
+					std::lock_guard<std::mutex> lock(mutex);
+
+					w->mvprint(short(t),0,"worker {:2} count {:8} {:>6.1f}%",t,i,i * 100.0 / nposts);
+				}
+				busy += now() - b0;
+				nap();
+			}
+			post_ns += uint64_t(busy * 1e9);
+			--running;
+		});
+
+	auto update = [&]() {
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if ( curses.dirty() )
+			w->refresh();
+	};
+
+	while ( running > 0 ) {
+		update();
+		usleep(1000);
+	}
+	update();
+
+	double secs = now() - t0;
+
+	for ( auto& th : threads )
+		th.join();
+	return Result{ "mutex", double(post_ns) / (double(nthreads) * nposts), secs,
+		uint64_t(nthreads) * nposts, 0, curses.stats().updates - updates };
+}
+
+//////////////////////////////////////////////////////////////////////
+// The last count of each worker must be on the screen
+//////////////////////////////////////////////////////////////////////
+
+static bool
+check(CppCurses& curses) {
+	std::vector<std::string> rows = curses.snapshot();
+	char want[64];
+
+	for ( unsigned t=0; t<nthreads; ++t ) {
+		snprintf(want,sizeof want,"worker %2u count %8u",t,nposts-1);
+		if ( rows[t].compare(0,strlen(want),want) != 0 )
+			return false;
+	}
+	return true;
+}
+
+static void
+usage(const char *cmd) {
+	fprintf(stderr,"Usage: %s [-p producers] [-n posts] [-b burst] [-s pause_us] [-l label] [-t]\n",cmd);
+	exit(2);
+}
+
+int
+main(int argc,char **argv) {
+	const char *label = "";
+	bool textf = false;
+	int optch;
+
+	while ( (optch = getopt(argc,argv,"p:n:b:s:l:th")) != -1 ) {
+		switch ( optch ) {
+		case 'p':
+			nthreads = strtoul(optarg,nullptr,10);
+			break;
+		case 'n':
+			nposts = strtoul(optarg,nullptr,10);
+			break;
+		case 'b':
+			burst = strtoul(optarg,nullptr,10);
+			break;
+		case 's':
+			pause_us = strtoul(optarg,nullptr,10);
+			break;
+		case 'l':
+			label = optarg;
+			break;
+		case 't':
+			textf = true;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if ( !nthreads || nthreads > 50 || !nposts || !burst )
+		usage(argv[0]);
+
+	CppCurses curses;
+	Window *w = curses.open_headless(60,200);
+	Result results[2];
+	bool ok[2];
+
+	if ( !w ) {
+		fprintf(stderr,"Unable to open a headless screen\n");
+		return 1;
+	}
+	results[0] = run_mutex(curses,w);
+	ok[0] = check(curses);
+	w->erase().refresh();
+	results[1] = run_queue(curses,w);
+	ok[1] = check(curses);
+	curses.close();
+
+	if ( textf )
+		printf("%-6s %12s %8s %10s %8s %8s %6s\n","mode","ns/post","secs","posted","dropped","updates","ok");
+	for ( unsigned x=0; x<2; ++x ) {
+		const Result& r = results[x];
+
+		if ( textf )
+			printf("%-6s %12.1f %8.2f %10lu %8lu %8lu %6s\n",r.mode,r.ns_per_post,r.secs,
+				(unsigned long)r.posted,(unsigned long)r.dropped,(unsigned long)r.updates,ok[x] ? "yes" : "no");
+		else	printf("{\"label\":\"%s\",\"mode\":\"%s\",\"producers\":%u,\"ns_per_post\":%.2f,\"secs\":%.3f,"
+				"\"posted\":%lu,\"dropped\":%lu,\"updates\":%lu,\"ok\":%s}\n",
+				label,r.mode,nthreads,r.ns_per_post,r.secs,(unsigned long)r.posted,
+				(unsigned long)r.dropped,(unsigned long)r.updates,ok[x] ? "true" : "false");
+	}
+	return ok[0] && ok[1] ? 0 : 1;
+}
+
+// End renderq.cpp
@@ -10,8 +10,22 @@
 #include <errno.h>
 #include <string.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <locale.h>
+#include <wchar.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+
+#include <algorithm>
 
 #include <cppcurses/cppcurses.hpp>
+#include <cppcurses/trace.hpp>
 
 #include <ncurses.h>
 
@@ -26,21 +40,211 @@ CppCurses::~CppCurses() {
 	}
 }
 
+//////////////////////////////////////////////////////////////////////
+// Close curses. With tracing compiled in, the trace is written to the
+// trace_to() path, or else to $CPPCURSES_TRACE_FILE (if set).
+//////////////////////////////////////////////////////////////////////
+
 void
 CppCurses::fini() {
+	purge();
+	zorder.clear();
+	single_write(false);
+	fini_events();
+	delete differ;
+	differ = nullptr;
+	outfd = -1;
+	if ( iofd >= 0 ) {
+		::close(iofd);
+		iofd = -1;
+	}
+	if ( inwin ) {
+		delwin((WINDOW*)inwin);
+		inwin = nullptr;
+	}
 	endwin();
+
+	if ( screen ) {
+		delscreen((SCREEN*)screen);
+		screen = nullptr;
+		fclose(outfp);
+		if ( infp )
+			fclose(infp);
+		if ( keyfd >= 0 )
+			::close(keyfd);
+		outfp = infp = nullptr;
+		keyfd = -1;
+	}
+	headlessf = openf = false;
+
+	if ( Trace::enabled() ) {
+		const char *path = trace_path.empty() ? getenv("CPPCURSES_TRACE_FILE") : trace_path.c_str();
+
+		if ( path && *path )
+			Trace::dump(path);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Curses needs the character type locale for UTF-8 text. If the
+// application has not selected one, use the environment's (or
+// C.UTF-8, when the environment does not name one either).
+//////////////////////////////////////////////////////////////////////
+
+void
+CppCurses::init_locale() {
+	auto is_c = [](const char *lc) {
+		return !lc || !strcmp(lc,"C") || !strcmp(lc,"POSIX");
+	};
+
+	if ( is_c(setlocale(LC_CTYPE,nullptr)) )
+		if ( is_c(setlocale(LC_CTYPE,"")) )
+			setlocale(LC_CTYPE,"C.UTF-8");
 }
 
+//////////////////////////////////////////////////////////////////////
+// Curses writes to its own dup of stdout rather than to stdout, so
+// that single_write() can point that fd at a memfd without touching
+// the application's (or another thread's) use of stdout.
+//////////////////////////////////////////////////////////////////////
+
 Window *
 CppCurses::open() {
 
 	if ( !openf ) {
-		mainw = new Window(this,initscr());
+		int fd = fcntl(fileno(stdout),F_DUPFD_CLOEXEC,0);
+
+		init_locale();
+		if ( fd < 0 || !(outfp = fdopen(fd,"w")) ) {
+			if ( fd >= 0 )
+				::close(fd);
+			return nullptr;
+		}
+		screen = newterm(nullptr,outfp,stdin);
+		if ( !screen ) {
+			fclose(outfp);
+			outfp = nullptr;
+			return nullptr;
+		}
+		mainw = new Window(this,stdscr);
+		outfd = fd;
+		init_events(fileno(stdin),true);
 		openf = true;
 	}
 	return mainw;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Open curses on a screen that exists only in memory: output is
+// discarded, and input comes from feed(). All of the Window API
+// (panels, subwindows, attributes and colours) works as usual, and
+// the resulting screen can be examined with snapshot() and cell().
+// This allows rendering to be tested and profiled without a tty.
+//////////////////////////////////////////////////////////////////////
+
+Window *
+CppCurses::open_headless(short rows,short cols,const char *term) {
+	int fds[2];
+
+	if ( openf )
+		return mainw;
+
+	if ( pipe2(fds,O_CLOEXEC) == -1 )
+		return nullptr;
+	init_locale();
+	infp = fdopen(fds[0],"r");
+	outfp = fopen("/dev/null","w");
+	keyfd = fds[1];
+	if ( infp && outfp )
+		screen = newterm(term,outfp,infp);
+
+	if ( !screen ) {
+		if ( infp )
+			fclose(infp);
+		else	::close(fds[0]);
+		if ( outfp )
+			fclose(outfp);
+		::close(keyfd);
+		infp = outfp = nullptr;
+		keyfd = -1;
+		return nullptr;
+	}
+
+	resize_term(rows,cols);
+	headlessf = true;
+	mainw = new Window(this,stdscr);
+	outfd = fileno(outfp);
+	init_events(fds[0],false);
+	openf = true;
+	return mainw;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Window pool: a released WindowHandle's window is hidden and kept
+// (up to max_retired of them), for reuse by a window of the same size
+//////////////////////////////////////////////////////////////////////
+
+void
+CppCurses::retire(Window *w) {
+
+	if ( !openf || retired.size() >= max_retired ) {
+		delete w;
+		return;
+	}
+	if ( w->sub && !w->borderf ) {
+		delwin((WINDOW*)w->sub);	// A subwindow() of the user's
+		w->sub = nullptr;
+	}
+	w->hide();
+	w->dirtyf = false;
+	w->retiredf = true;
+	w->resize_fn = nullptr;			// Its arg may be gone
+	w->resize_arg = nullptr;
+	retired.push_back(w);
+	if ( !framec )
+		w->do_update();
+}
+
+Window *
+CppCurses::reuse(short nlines,short ncols,bool border) {
+
+	for ( size_t x=retired.size(); x-- > 0; ) {
+		Window *w = retired[x];
+
+		if ( w->borderf == border && getmaxy((WINDOW*)w->win) == nlines && getmaxx((WINDOW*)w->win) == ncols ) {
+			retired[x] = retired.back();
+			retired.pop_back();
+			w->retiredf = false;
+			return w;
+		}
+	}
+	return nullptr;
+}
+
+void
+CppCurses::purge() {
+
+	++framec;				// No updates for the deletions
+	for ( Window *w : retired )
+		delete w;
+	retired.clear();
+	--framec;
+}
+
+void
+CppCurses::pool_limit(unsigned n) {
+
+	max_retired = n;
+	if ( retired.size() > n ) {
+		++framec;
+		while ( retired.size() > n ) {
+			delete retired.back();
+			retired.pop_back();
+		}
+		--framec;
+	}
+}
+
 bool
 CppCurses::close() {
 
@@ -51,6 +255,719 @@ CppCurses::close() {
 	return !mainw;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Resize curses to the terminal's new size, as reported by SIGWINCH
+// (readch() and wait_event() do this themselves; an InputQueue
+// reports it as an InputEvent::Type::Resize event instead).
+//
+// The windows are laid out anew in place (see Window::on_resize()).
+// With a frame rate cap, or between begin_frame() and end_frame(),
+// this is deferred to the next update, so that the burst of resizes
+// of a window drag costs one relayout per frame: the last size wins.
+//////////////////////////////////////////////////////////////////////
+
+void
+CppCurses::resize(short rows,short cols) {
+
+	if ( !openf || rows <= 0 || cols <= 0 )
+		return;
+	++statistics.resizes;
+	resize_rows = rows;
+	resize_cols = cols;
+	resizef = dirtyf = true;
+	if ( framec > 0 || frame_ns > 0 )
+		pendingf = true;
+	else	relayout();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Apply the pending resize: border windows lose their frame first
+// (resize_term() grows windows that reach the edge, which would leave
+// the old frame inside), then each window is given its geometry, or
+// its on_resize() function is called. Refreshes made by the
+// functions are part of the update. The terminal may have reflowed
+// its contents, so the next update repaints it.
+//////////////////////////////////////////////////////////////////////
+
+void
+CppCurses::relayout() {
+	CPPCURSES_SPAN("CppCurses::relayout");
+	std::vector<Window*> windows;		// The functions may restack
+	bool sizedf = resize_rows != LINES || resize_cols != COLS;
+
+	windows.reserve(zorder.size());
+	for ( Window *w : zorder )
+		if ( !w->retiredf )		// Placed again by recycle()
+			windows.push_back(w);
+	resizef = false;
+	++statistics.relayouts;
+	++framec;
+	for ( Window *w : windows )
+		if ( w->borderf )
+			w->unframe();
+	resize_term(resize_rows,resize_cols);
+	for ( Window *w : windows )
+		w->relayout(resize_rows,resize_cols);
+	--framec;
+	if ( sizedf )
+		clearok(curscr,TRUE);
+	dirtyf = true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Touch what the windows below above show of an area that above no
+// longer covers (libpanel only does this for moved or hidden panels)
+//////////////////////////////////////////////////////////////////////
+
+void
+CppCurses::expose(int y,int x,int nlines,int ncols,Window *above) {
+
+	for ( Window *w : zorder ) {
+		WINDOW *win = (WINDOW*)w->win;
+
+		if ( w == above )
+			break;
+		if ( w->hiddenf )
+			continue;
+
+		int top = std::max(y,getbegy(win)), bot = std::min(y + nlines,getbegy(win) + getmaxy(win));
+		int left = std::max(x,getbegx(win)), right = std::min(x + ncols,getbegx(win) + getmaxx(win));
+
+		if ( top < bot && left < right )
+			touchline(win,top - getbegy(win),bot - top);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Single write frames: curses' doupdate() writes a frame in pieces
+// (a write() per few lines, as it checks for typeahead, and whenever
+// its buffer fills). With single_write(), its output fd is pointed at
+// a memfd for the duration of doupdate(), and the gathered frame goes
+// to the terminal in one writev(), optionally between the DEC 2026
+// synchronized update set and reset, so that the terminal shows the
+// frame all at once. The typeahead check is turned off meanwhile: it
+// flushes (and polls the input) every few lines, and would cut the
+// frame short when a key is pending. The diffing renderer always
+// writes once; it takes the sync setting.
+//
+// outfd is curses' private dup of stdout (see open()), so the dup2()
+// leaves stdout itself alone. Curses still write()s about a line at
+// a time into the memfd: only the terminal sees a single write.
+//////////////////////////////////////////////////////////////////////
+
+bool
+CppCurses::single_write(bool on,Sync sync) {
+
+	if ( on && !openf )
+		return false;
+
+	if ( !on ) {
+		bool wasf = framefd >= 0;
+
+		if ( framemap )
+			munmap(framemap,framemap_len);
+		if ( framefd >= 0 )
+			::close(framefd);
+		if ( ttyfd_out >= 0 )
+			::close(ttyfd_out);
+		framemap = nullptr;
+		framemap_len = 0;
+		framefd = ttyfd_out = -1;
+		syncf = false;
+		if ( wasf && openf )
+			check_typeahead();
+	} else if ( framefd < 0 ) {
+		framefd = memfd_create("cppcurses-frame",MFD_CLOEXEC);
+		ttyfd_out = fcntl(outfd,F_DUPFD_CLOEXEC,0);
+		if ( framefd < 0 || ttyfd_out < 0 || !map_frame(1024 * 1024) ) {
+			single_write(false);
+			return false;
+		}
+		delay_output(0);			// Flush what curses holds
+		check_typeahead();
+	}
+
+	if ( on ) {
+		const char *cap = tigetstr("Sync");
+
+		syncf = sync == Sync::On || (sync == Sync::Auto && cap && cap != (char*)-1);
+	}
+	if ( differ )
+		differ->sync(syncf);
+	return on;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Turn curses' typeahead check off while single_write() gathers the
+// frames, or an InputQueue reads the terminal: either way, a pending
+// key would cut doupdate() short, leaving the frame half written
+// (its windows are no longer dirty, so nothing would finish it).
+//////////////////////////////////////////////////////////////////////
+
+void
+CppCurses::check_typeahead() {
+	typeahead(framefd >= 0 || inputqs > 0 ? -1 : ttyfd);
+}
+
+bool
+CppCurses::map_frame(size_t len) {
+
+	if ( framemap )
+		munmap(framemap,framemap_len);
+	framemap = nullptr;
+	framemap_len = 0;
+	if ( ftruncate(framefd,len) == -1 )
+		return false;
+
+	void *p = mmap(nullptr,len,PROT_READ,MAP_SHARED,framefd,0);
+
+	if ( p == MAP_FAILED )
+		return false;
+	framemap = (char*)p;
+	framemap_len = len;
+	return true;
+}
+
+void
+CppCurses::write_frame() {
+	static const char sync_set[] = "\033[?2026h", sync_reset[] = "\033[?2026l";
+
+	if ( framefd < 0 ) {
+		doupdate();
+		return;
+	}
+
+	dup2(framefd,outfd);
+	doupdate();
+	dup2(ttyfd_out,outfd);
+
+	off_t len = lseek(framefd,0,SEEK_CUR);
+
+	frame_out = 0;
+	if ( len <= 0 )
+		return;
+	lseek(framefd,0,SEEK_SET);
+	if ( size_t(len) > framemap_len && !map_frame((size_t(len) + 0xFFFFF) & ~size_t(0xFFFFF)) ) {
+		single_write(false);			// Lost the frame: repaint
+		clearok(curscr,TRUE);
+		dirtyf = true;
+		return;
+	}
+
+	iovec iov[3] = {
+		{ (void*)sync_set, syncf ? sizeof sync_set - 1 : 0 },
+		{ framemap, size_t(len) },
+		{ (void*)sync_reset, syncf ? sizeof sync_reset - 1 : 0 },
+	};
+	iovec *v = syncf ? iov : iov + 1;
+	int nv = syncf ? 3 : 1;
+
+	frame_out = iov[0].iov_len + iov[1].iov_len + iov[2].iov_len;
+	while ( nv > 0 ) {
+		ssize_t rc = writev(outfd,v,nv);
+
+		if ( rc < 0 ) {
+			if ( errno == EAGAIN || errno == EWOULDBLOCK ) {
+				pollfd pfd = { outfd, POLLOUT, 0 };
+
+				poll(&pfd,1,-1);	// Non-blocking: wait for room
+				continue;
+			}
+			if ( errno == EINTR )
+				continue;
+			break;
+		}
+		while ( nv > 0 && size_t(rc) >= v->iov_len ) {
+			rc -= v->iov_len;
+			++v;
+			--nv;
+		}
+		if ( nv > 0 ) {
+			v->iov_base = (char*)v->iov_base + rc;
+			v->iov_len -= rc;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Select the library's diffing renderer (on) or doupdate() (off) for
+// the screen updates. Either way the next update repaints the screen,
+// since the other does not know what is on the terminal. Output that
+// curses has buffered (its terminal setup, until the first doupdate())
+// is flushed first by delay_output().
+//////////////////////////////////////////////////////////////////////
+
+bool
+CppCurses::diff_render(bool on) {
+
+	if ( !openf )
+		return false;
+	if ( on && !differ ) {
+		delay_output(0);
+		differ = new ScreenDiff(outfd);
+		differ->sync(syncf);
+	} else if ( !on && differ ) {
+		delete differ;
+		differ = nullptr;
+		clearok(curscr,TRUE);
+	}
+	dirtyf = true;
+	return on;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Frames: refreshes between begin_frame() and end_frame() are
+// deferred, and end_frame() performs at most one screen update.
+//////////////////////////////////////////////////////////////////////
+
+void
+CppCurses::begin_frame() {
+	++framec;
+}
+
+void
+CppCurses::end_frame() {
+
+	assert(framec > 0);
+	if ( --framec == 0 && dirtyf && mainw )
+		mainw->refresh();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Frame rate cap: refresh() and request_refresh() update the screen
+// at most fps times a second. A refresh that comes too early marks
+// the screen pending, and the next frame boundary performs a single
+// update for all of the requests since. readch() and wait_event()
+// wake up for the boundary themselves; other loops call
+// poll_refresh(). refresh_now() bypasses the cap (for input echo).
+//////////////////////////////////////////////////////////////////////
+
+void
+CppCurses::max_fps(unsigned fps) {
+
+	frame_ns = fps > 0 ? 1000000000L / long(fps) : 0;
+	if ( !frame_ns )
+		poll_refresh();
+}
+
+void
+CppCurses::request_refresh() {
+
+	if ( mainw )
+		mainw->refresh();
+}
+
+void
+CppCurses::refresh_now() {
+
+	if ( !mainw || framec > 0 )
+		return;
+	++statistics.requests;
+	mainw->composite();
+}
+
+bool
+CppCurses::poll_refresh() {
+
+	if ( !pendingf || framec > 0 || !frame_due() )
+		return false;
+	mainw->composite();
+	return true;
+}
+
+bool
+CppCurses::frame_due() const {
+	return !frame_ns || now_ns() - last_frame >= frame_ns;
+}
+
+int64_t
+CppCurses::now_ns() {
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Output accounting: the bytes and write() calls of each update are
+// the difference of the updating thread's I/O counters (wchar and
+// syscw of /proc/<pid>/task/<tid>/io) across doupdate(). Curses
+// writes to the terminal directly (the same fd carries the terminal
+// modes), so the counters are read rather than the output wrapped.
+//////////////////////////////////////////////////////////////////////
+
+void
+CppCurses::account_output(bool on) {
+
+	accountf = on;
+	if ( !on && iofd >= 0 ) {
+		::close(iofd);
+		iofd = -1;
+	}
+}
+
+bool
+CppCurses::io_counts(unsigned long& wchar,unsigned long& syscw) {
+	char buf[512];
+	pid_t tid = gettid();
+	const char *wp, *sp;
+	ssize_t n;
+
+	if ( iofd < 0 || tid != iotid ) {
+		if ( iofd >= 0 )
+			::close(iofd);
+		snprintf(buf,sizeof buf,"/proc/self/task/%d/io",int(tid));
+		iofd = ::open(buf,O_RDONLY|O_CLOEXEC);
+		iotid = tid;
+		if ( iofd < 0 )
+			return false;
+	}
+
+	n = pread(iofd,buf,sizeof buf - 1,0);
+	if ( n <= 0 )
+		return false;
+	buf[n] = 0;
+	wp = strstr(buf,"wchar:");
+	sp = strstr(buf,"syscw:");
+	if ( !wp || !sp )
+		return false;
+	wchar = strtoul(wp + 6,nullptr,10);
+	syscw = strtoul(sp + 6,nullptr,10);
+	return true;
+}
+
+void
+CppCurses::output_begin(FrameStats& mark) {
+
+	if ( !io_counts(mark.bytes,mark.writes) )
+		mark.windows = ~0u;		// Counters unavailable
+	mark.flush_ns = now_ns();
+}
+
+void
+CppCurses::output_end(const FrameStats& mark,const FrameStats& synced) {
+	int64_t now = now_ns();
+	unsigned long wchar, syscw;
+
+	frame_stats.flush_ns = now - mark.flush_ns;
+	frame_stats.windows = synced.windows;
+	frame_stats.cells = synced.cells;
+	frame_stats.top = synced.top;
+	frame_stats.top_cells = synced.top_cells;
+	if ( framefd >= 0 && !differ ) {
+		frame_stats.bytes = frame_out;		// The memfd writes don't count
+		frame_stats.writes = frame_out > 0;
+	} else if ( mark.windows != ~0u && io_counts(wchar,syscw) ) {
+		frame_stats.bytes = wchar - mark.bytes;
+		frame_stats.writes = syscw - mark.writes;
+	} else	frame_stats.bytes = frame_stats.writes = 0;
+
+	statistics.out_bytes += frame_stats.bytes;
+	statistics.out_writes += frame_stats.writes;
+	statistics.flush_ns += frame_stats.flush_ns;
+	if ( frame_stats.bytes > worst_stats.bytes )
+		worst_stats = frame_stats;
+	if ( frame_stats.bytes > dump_worst )
+		dump_worst = frame_stats.bytes;
+
+	if ( dumpfp && now - dump_last >= dump_ns )
+		dump_stats(dumpfp);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Write one line of output stats for the updates since the last dump
+// (dump_every() does this periodically, from the update)
+//////////////////////////////////////////////////////////////////////
+
+void
+CppCurses::dump_every(FILE *fp,unsigned ms) {
+
+	dumpfp = ms > 0 ? fp : nullptr;
+	dump_ns = long(ms) * 1000000L;
+	dump_last = now_ns();
+	dumped = statistics;
+	dump_worst = 0;
+	if ( dumpfp )
+		accountf = true;
+}
+
+void
+CppCurses::dump_stats(FILE *fp) {
+	unsigned long updates = statistics.updates - dumped.updates;
+	unsigned long bytes = statistics.out_bytes - dumped.out_bytes;
+
+	fprintf(fp,"cppcurses: %lu updates (%lu requested), %lu bytes (%lu/update, worst %lu), "
+		"%lu writes, %.3f ms flushing\n",
+		updates,statistics.requests - dumped.requests,
+		bytes,updates ? bytes / updates : 0,dump_worst,
+		statistics.out_writes - dumped.out_writes,
+		double(statistics.flush_ns - dumped.flush_ns) / 1e6);
+	fflush(fp);
+
+	dumped = statistics;
+	dump_worst = 0;
+	dump_last = now_ns();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Set up the event loop: the terminal input, SIGWINCH (delivered
+// through a signalfd rather than a handler) and a deadline timer
+// are all waited on by one epoll_wait(), so that an idle program
+// sleeps in the kernel until something actually happens.
+//////////////////////////////////////////////////////////////////////
+
+void
+CppCurses::init_events(int fd,bool sigwinch) {
+	sigset_t mask;
+	epoll_event ev;
+
+	ttyfd = fd;
+
+	sigemptyset(&mask);
+	if ( sigwinch )
+		sigaddset(&mask,SIGWINCH);
+	pthread_sigmask(SIG_BLOCK,&mask,&osigmask);
+
+	epfd = epoll_create1(EPOLL_CLOEXEC);
+	sigfd = signalfd(-1,&mask,SFD_NONBLOCK|SFD_CLOEXEC);
+	tmrfd = timerfd_create(CLOCK_MONOTONIC,TFD_NONBLOCK|TFD_CLOEXEC);
+	assert(epfd >= 0 && sigfd >= 0 && tmrfd >= 0);
+
+	memset(&ev,0,sizeof ev);
+	ev.events = EPOLLIN;
+	ev.data.fd = ttyfd;
+	epoll_ctl(epfd,EPOLL_CTL_ADD,ttyfd,&ev);
+	ev.data.fd = sigfd;
+	epoll_ctl(epfd,EPOLL_CTL_ADD,sigfd,&ev);
+	ev.data.fd = tmrfd;
+	epoll_ctl(epfd,EPOLL_CTL_ADD,tmrfd,&ev);
+}
+
+void
+CppCurses::fini_events() {
+
+	if ( epfd < 0 )
+		return;
+	::close(tmrfd);
+	::close(sigfd);
+	::close(epfd);
+	tmrfd = sigfd = epfd = ttyfd = -1;
+	pthread_sigmask(SIG_SETMASK,&osigmask,nullptr);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Block until input, a resize or the timeout (ms < 0 waits forever)
+//////////////////////////////////////////////////////////////////////
+
+Event
+CppCurses::wait_event(int ms) {
+	timespec deadline;
+
+	if ( ms < 0 )
+		return wait_until(nullptr);
+	to_deadline(ms,deadline);
+	return wait_until(&deadline);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Compute the CLOCK_MONOTONIC time ms milliseconds from now
+//////////////////////////////////////////////////////////////////////
+
+void
+CppCurses::to_deadline(int ms,timespec& deadline) {
+
+	clock_gettime(CLOCK_MONOTONIC,&deadline);
+	deadline.tv_sec += ms / 1000;
+	deadline.tv_nsec += long(ms % 1000) * 1000000L;
+	if ( deadline.tv_nsec >= 1000000000L ) {
+		++deadline.tv_sec;
+		deadline.tv_nsec -= 1000000000L;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Block until input, a resize or the CLOCK_MONOTONIC deadline
+//////////////////////////////////////////////////////////////////////
+
+Event
+CppCurses::wait_until(const timespec *deadline) {
+	itimerspec its;
+	epoll_event ev;
+	Event event = Event::Timeout;
+	bool armedf = false;
+	int ch, n;
+
+	// Curses may already hold input that it read ahead of us:
+	ch = wgetch((WINDOW*)inwin);
+	if ( ch != ERR ) {
+		ungetch(ch);
+		return Event::Input;
+	}
+
+	for (;;) {
+		poll_refresh();
+
+		if ( winchf && !resizef ) {
+			winchf = false;		// The resize was applied
+			ungetch(KEY_RESIZE);
+			event = Event::Resize;
+			break;
+		}
+
+		// Wake up for the deadline, or a pending frame if sooner (one
+		// pending inside begin_frame() is left to end_frame()):
+		bool framef = pendingf && framec == 0 && frame_ns > 0;
+
+		memset(&its,0,sizeof its);
+		if ( deadline )
+			its.it_value = *deadline;
+		if ( framef ) {
+			int64_t at = last_frame + frame_ns;
+
+			if ( !deadline || at < int64_t(deadline->tv_sec) * 1000000000 + deadline->tv_nsec ) {
+				its.it_value.tv_sec = at / 1000000000;
+				its.it_value.tv_nsec = at % 1000000000;
+			}
+		}
+		if ( armedf || deadline || framef ) {
+			timerfd_settime(tmrfd,TFD_TIMER_ABSTIME,&its,nullptr);
+			armedf = deadline || framef;
+		}
+
+		n = epoll_wait(epfd,&ev,1,-1);
+		if ( n < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			break;
+		}
+		if ( ev.data.fd == ttyfd ) {
+			event = Event::Input;
+		} else if ( ev.data.fd == sigfd ) {
+			signalfd_siginfo si;
+			winsize ws;
+
+			while ( read(sigfd,&si,sizeof si) == sizeof si )
+				;		// Coalesce pending SIGWINCHes
+			if ( ioctl(ttyfd,TIOCGWINSZ,&ws) == 0 && ws.ws_row > 0 && ws.ws_col > 0 )
+				resize(ws.ws_row,ws.ws_col);
+			winchf = true;		// Reported once applied (above)
+			continue;
+		} else	{
+			uint64_t expiries;
+
+			if ( read(tmrfd,&expiries,sizeof expiries) != sizeof expiries )
+				continue;	// Spurious: timer was rearmed
+			if ( !deadline || now_ns() < int64_t(deadline->tv_sec) * 1000000000 + deadline->tv_nsec )
+				continue;	// Frame boundary: update and wait on
+			event = Event::Timeout;
+		}
+		break;
+	}
+
+	if ( armedf ) {
+		memset(&its,0,sizeof its);
+		timerfd_settime(tmrfd,0,&its,nullptr);	// Disarm
+		armedf = false;
+	}
+	return event;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Type keys into a headless screen (escape sequences are decoded
+// according to the terminal type given to open_headless()).
+//////////////////////////////////////////////////////////////////////
+
+bool
+CppCurses::feed(const char *keys,size_t n) {
+
+	if ( keyfd < 0 )
+		return false;
+
+	while ( n > 0 ) {
+		ssize_t rc = write(keyfd,keys,n);
+
+		if ( rc < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			return false;
+		}
+		keys += rc;
+		n -= rc;
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return the text of the screen, as of the last update
+//////////////////////////////////////////////////////////////////////
+
+std::vector<std::string>
+CppCurses::snapshot() {
+	std::vector<std::string> rows;
+	std::vector<wchar_t> wtext;
+	int cy, cx, nrows, ncols;
+	char mb[MB_LEN_MAX];
+
+	if ( !openf )
+		return rows;
+
+	WINDOW *scr = differ ? newscr : curscr;	// ScreenDiff leaves curscr alone
+
+	getyx(scr,cy,cx);
+	getmaxyx(scr,nrows,ncols);
+	wtext.resize(ncols+1);
+	rows.reserve(nrows);
+	for ( int y=0; y<nrows; ++y ) {
+		int n = mvwinnwstr(scr,y,0,wtext.data(),ncols);
+		std::string& row = rows.emplace_back();
+		mbstate_t mbs{};
+
+		for ( int x=0; x<n; ++x ) {
+			size_t len = wcrtomb(mb,wtext[x],&mbs);
+
+			if ( len == size_t(-1) ) {
+				row += '?';
+				mbs = mbstate_t{};
+			} else	row.append(mb,len);
+		}
+	}
+	wmove(scr,cy,cx);
+	return rows;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return a cell of the screen, as of the last update
+//////////////////////////////////////////////////////////////////////
+
+bool
+CppCurses::cell(int y,int x,Cell& cell) {
+	int cy, cx, nrows, ncols, pair = 0;
+	cchar_t cc;
+	wchar_t wch[CCHARW_MAX+1];
+	attr_t attrs;
+	short spair;
+
+	if ( !openf )
+		return false;
+
+	WINDOW *scr = differ ? newscr : curscr;
+
+	getmaxyx(scr,nrows,ncols);
+	if ( y < 0 || y >= nrows || x < 0 || x >= ncols )
+		return false;
+
+	getyx(scr,cy,cx);
+	mvwin_wch(scr,y,x,&cc);
+	wmove(scr,cy,cx);
+
+	if ( getcchar(&cc,wch,&attrs,&spair,&pair) == ERR )
+		return false;
+	cell.ch = uint32_t(wch[0]);
+	cell.attrs = Window::wattr_t(attrs & A_ATTRIBUTES & ~A_COLOR);
+	cell.pair = Window::colpair_t(pair);
+	return true;
+}
+
 #undef getch
 
 void
@@ -59,8 +976,8 @@ CppCurses::init_colours() {
 	assert(!coloursf);
 	if ( has_colors() ) {
 		start_color();
-		Window::init_maps(true);
-	}
+		Window::init_maps(true,max_pairs);
+	} else	Window::init_maps(false,0);
 }
 
 // End cppcurses.cpp
@@ -6,25 +6,171 @@
 #ifndef CPPCURSES_HPP
 #define CPPCURSES_HPP
 
+#include <stdio.h>
+#include <signal.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+
 #include <cppcurses/window.hpp>
+#include <cppcurses/screendiff.hpp>
+
+#include <string>
+#include <vector>
 
 class CppCurses {
 	friend Window;
-	
+	friend class InputQueue;
+	friend class WindowHandle;
+
+public:	struct Stats {
+		unsigned long	updates = 0;	// Screen composites performed
+		unsigned long	requests = 0;	// Refreshes requested (see max_fps())
+		unsigned long	pair_allocs = 0; // Colour pairs initialized on demand
+		unsigned long	pair_evictions = 0; // .. of which replaced an LRU pair
+		unsigned long	window_reuses = 0; // Windows taken from the pool
+		unsigned long	borders_drawn = 0; // Frames of border windows drawn
+		unsigned long	resizes = 0;	// Terminal resizes (see resize())
+		unsigned long	relayouts = 0;	// .. applied (at most one per frame)
+		unsigned long	out_bytes = 0;	// Bytes written by updates (see account_output())
+		unsigned long	out_writes = 0;	// .. by this many write() calls
+		unsigned long	flush_ns = 0;	// Time spent writing updates (doupdate())
+	};
+
+	enum class Sync {			// Synchronized updates (DEC mode 2026)
+		Off,
+		Auto,				// If terminfo has the Sync capability
+		On,
+	};
+
+	struct FrameStats {			// One screen update (see account_output())
+		unsigned long	bytes = 0;	// Bytes written to the terminal
+		unsigned long	writes = 0;	// write() calls
+		unsigned long	flush_ns = 0;	// Time spent in doupdate()
+		unsigned	windows = 0;	// Windows synced (drawn into)
+		unsigned long	cells = 0;	// Cells of their changed rows
+		const Window	*top = nullptr;	// Window with the most (nullptr once deleted)
+		unsigned long	top_cells = 0;	// .. its cells
+	};
+
+private:
 	Window		*mainw = nullptr;
 	bool		openf = false;
 	bool		coloursf = false;
+	bool		headlessf = false; // Screen is in memory only
+	void		*screen = nullptr; // SCREEN from newterm()
+	FILE		*outfp = nullptr; // Curses output (dup of stdout, or /dev/null)
+	FILE		*infp = nullptr; // Headless input (pipe)
+	int		keyfd = -1;	// Headless input pipe, write end
+	int		outfd = -1;	// Terminal output
+	ScreenDiff	*differ = nullptr; // Renderer used in place of doupdate()
+	int		framefd = -1;	// memfd gathering doupdate()'s output
+	int		ttyfd_out = -1;	// dup() of outfd, while framefd swaps in
+	char		*framemap = nullptr; // framefd mapped
+	size_t		framemap_len = 0;
+	unsigned long	frame_out = 0;	// Bytes of the last gathered frame
+	bool		syncf = false;	// Wrap frames in DEC 2026 set/reset
+	unsigned	inputqs = 0;	// InputQueues reading ttyfd
+	bool		dirtyf = false;	// Drawn into since the last update
+	unsigned	framec = 0;	// begin_frame() nesting level
+	long		frame_ns = 0;	// Minimum ns between updates (0 = no cap)
+	int64_t		last_frame = 0;	// CLOCK_MONOTONIC ns of the last update
+	bool		pendingf = false; // A refresh waits for the next frame
+	bool		resizef = false; // A resize waits for the next update
+	short		resize_rows = 0, resize_cols = 0; // .. to this size
+	bool		winchf = false;	// SIGWINCH to report once applied
+	unsigned	max_pairs = 0;	// Limit of colour pairs (0 = terminal's)
+	void		*inwin = nullptr; // Input pad (never refreshed)
+	std::vector<Window*> zorder;	// Windows, bottom to top (as the panels)
+	std::vector<Window*> retired;	// Hidden windows kept for reuse
+	unsigned	max_retired = 32;
+	Stats		statistics;
+
+	bool		accountf = false; // Account for the output of updates
+	int		iofd = -1;	// /proc/<tid>/io of the updating thread
+	pid_t		iotid = 0;
+	FrameStats	frame_stats;	// The last update
+	FrameStats	worst_stats;	// The update that wrote the most
+	FILE		*dumpfp = nullptr; // Periodic stats dump
+	long		dump_ns = 0;	// .. interval
+	int64_t		dump_last = 0;	// .. time of the last dump
+	Stats		dumped;		// statistics as of the last dump
+	unsigned long	dump_worst = 0;	// Most bytes of an update since
+	std::string	trace_path;	// Trace dumped here by close()
+
+	int		ttyfd = -1;	// Terminal input
+	int		epfd = -1;	// epoll(7) set of the fds below
+	int		sigfd = -1;	// signalfd(2) for SIGWINCH
+	int		tmrfd = -1;	// timerfd(2) for wait deadlines
+	sigset_t	osigmask;	// Signal mask prior to open()
 
 	void init_colours();
+	static void init_locale();
+	void init_events(int fd,bool sigwinch);
+	void fini_events();
 	void fini();
+	void retire(Window *w);
+	Window *reuse(short nlines,short ncols,bool border);
+	void purge();
+	void relayout();
+	void expose(int y,int x,int nlines,int ncols,Window *above);
+
+	Event wait_event(int ms);
+	Event wait_until(const timespec *deadline);
+	static void to_deadline(int ms,timespec& deadline);
+	static int64_t now_ns();
+	bool frame_due() const;
+	bool io_counts(unsigned long& wchar,unsigned long& syscw);
+	void output_begin(FrameStats& mark);
+	void output_end(const FrameStats& mark,const FrameStats& synced);
+	void write_frame();
+	bool map_frame(size_t len);
+	void check_typeahead();
 
 public:	CppCurses();
 	~CppCurses();
 
 	Window *open();
+	Window *open_headless(short rows,short cols,const char *term="xterm-256color");
 	bool close();
 
 	Window *main_window() { return mainw; }
+
+	void resize(short rows,short cols);	// Apply a terminal resize
+
+	void begin_frame();
+	void end_frame();
+	bool dirty() const { return dirtyf; }
+
+	void max_fps(unsigned fps);		// Cap screen updates (0 = none)
+	void request_refresh();			// Update at the next frame
+	void refresh_now();			// Update immediately (input echo)
+	bool poll_refresh();			// Perform a due deferred update
+
+	void pair_limit(unsigned n) { max_pairs = n; }	// Call before open()
+	void pool_limit(unsigned n);			// Retired windows kept (32)
+
+	const Stats& stats() const { return statistics; }
+
+	void account_output(bool on=true);		// Count update bytes and writes
+	const FrameStats& frame() const { return frame_stats; }
+	const FrameStats& worst_frame() const { return worst_stats; }
+	void dump_every(FILE *fp,unsigned ms);		// Periodic dump_stats() (0 = none)
+	void dump_stats(FILE *fp);			// One line of output stats
+
+	// One terminal write() per update. While doupdate() runs, curses'
+	// private output fd (a dup of stdout) is dup2()ed to a memfd.
+	bool single_write(bool on,Sync sync=Sync::Auto);
+	bool synced() const { return syncf; }
+	bool diff_render(bool on);			// Library renderer (see screendiff.hpp)
+	const ScreenDiff *diff_renderer() const { return differ; }
+
+	void trace_to(const char *path) { trace_path = path ? path : ""; } // See trace.hpp
+
+	bool headless() const { return headlessf; }
+	bool feed(const char *keys,size_t n);		// Headless input
+	std::vector<std::string> snapshot();		// Screen text by row
+	bool cell(int y,int x,Cell& cell);		// Screen cell
 };
 
 #endif // CPPCURSES_HPP
@@ -0,0 +1,322 @@
+//////////////////////////////////////////////////////////////////////
+// format.hpp -- C++ NCurses Class Library - Type safe formatting
+// Date: Sun Oct 18 03:47:18 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#ifndef FORMAT_HPP
+#define FORMAT_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+//////////////////////////////////////////////////////////////////////
+// Format strings follow std::format: "{}" fields, optionally with
+// an argument index and a spec, as in "{0:>8.2f}". The spec is
+//
+//	[[fill]align][sign][#][0][width][.precision][type]
+//
+// where align is one of < > ^, sign is one of + - space, and the
+// types are d x X o b B c (integers), f F e E g G (floating point),
+// s (strings and bool) and p (pointers). "{{" and "}}" are literal
+// braces. Format strings are checked against the argument types at
+// compile time: a mismatch is a compile error.
+//////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////
+// One argument, captured by value (strings are not copied)
+//////////////////////////////////////////////////////////////////////
+
+class FormatArg {
+public:	enum class Type : uint8_t {
+		Int,
+		Uint,
+		Double,
+		Bool,
+		Char,
+		String,
+		Pointer,
+	};
+
+	Type			type = Type::Int;
+	union {
+		long long	i = 0;
+		unsigned long long u;
+		double		d;
+		bool		b;
+		char		c;
+		const void	*p;
+		struct {
+			const char *ptr;
+			size_t	len;
+		}		s;
+	};
+
+	template <typename T>
+	static constexpr Type
+	type_of() {
+		using U = std::decay_t<T>;
+
+		if constexpr ( std::is_same_v<U,bool> )
+			return Type::Bool;
+		else if constexpr ( std::is_same_v<U,char> )
+			return Type::Char;
+		else if constexpr ( std::is_integral_v<U> && std::is_signed_v<U> )
+			return Type::Int;
+		else if constexpr ( std::is_integral_v<U> )
+			return Type::Uint;
+		else if constexpr ( std::is_floating_point_v<U> )
+			return Type::Double;
+		else if constexpr ( std::is_same_v<U,const char *> || std::is_same_v<U,char *>
+		  || std::is_same_v<U,std::string> || std::is_same_v<U,std::string_view> )
+			return Type::String;
+		else if constexpr ( std::is_pointer_v<U> || std::is_null_pointer_v<U> )
+			return Type::Pointer;
+		else
+			static_assert(sizeof(U) == 0,"type cannot be formatted");
+	}
+
+	FormatArg() {}
+
+	template <typename T>
+	FormatArg(const T& v) : type(type_of<T>()) {
+		using U = std::decay_t<T>;
+
+		if constexpr ( std::is_same_v<U,bool> )
+			b = v;
+		else if constexpr ( std::is_same_v<U,char> )
+			c = v;
+		else if constexpr ( std::is_integral_v<U> && std::is_signed_v<U> )
+			i = v;
+		else if constexpr ( std::is_integral_v<U> )
+			u = v;
+		else if constexpr ( std::is_floating_point_v<U> )
+			d = v;
+		else if constexpr ( std::is_same_v<U,std::string> || std::is_same_v<U,std::string_view> ) {
+			s.ptr = v.data();
+			s.len = v.size();
+		} else if constexpr ( std::is_same_v<U,const char *> || std::is_same_v<U,char *> ) {
+			const char *str = v;
+
+			s.ptr = str ? str : "(null)";
+			s.len = std::char_traits<char>::length(s.ptr);
+		} else
+			p = v;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////
+// A replacement field's spec
+//////////////////////////////////////////////////////////////////////
+
+struct FormatSpec {
+	int		arg = -1;		// Explicit argument index
+	char		fill = ' ';
+	char		align = 0;		// '<', '>', '^' or 0 (default)
+	char		sign = '-';
+	bool		alt = false;		// '#'
+	bool		zero = false;		// '0'
+	int		width = 0;
+	int		precision = -1;
+	char		type = 0;
+
+	//////////////////////////////////////////////////////////////
+	// Parse the field starting after its '{', returning the index
+	// of the character after its '}'
+	//////////////////////////////////////////////////////////////
+
+	constexpr size_t
+	parse(std::string_view fmt,size_t x) {
+		auto is_digit = [](char ch) { return ch >= '0' && ch <= '9'; };
+		auto is_align = [](char ch) { return ch == '<' || ch == '>' || ch == '^'; };
+		auto at = [&](size_t px) { return px < fmt.size() ? fmt[px] : '\0'; };
+
+		if ( is_digit(at(x)) ) {
+			arg = 0;
+			while ( is_digit(at(x)) )
+				arg = arg * 10 + (fmt[x++] - '0');
+		}
+		if ( at(x) == '}' )
+			return x + 1;
+		if ( at(x) != ':' )
+			throw "invalid format field";
+		++x;
+
+		if ( at(x) && at(x) != '}' && is_align(at(x+1)) ) {
+			if ( at(x) == '{' )
+				throw "invalid fill character";
+			fill = fmt[x];
+			align = fmt[x+1];
+			x += 2;
+		} else if ( is_align(at(x)) )
+			align = fmt[x++];
+
+		if ( at(x) == '+' || at(x) == '-' || at(x) == ' ' )
+			sign = fmt[x++];
+		if ( at(x) == '#' ) {
+			alt = true;
+			++x;
+		}
+		if ( at(x) == '0' ) {
+			zero = true;
+			++x;
+		}
+		while ( is_digit(at(x)) )
+			width = width * 10 + (fmt[x++] - '0');
+		if ( at(x) == '.' ) {
+			++x;
+			if ( !is_digit(at(x)) )
+				throw "missing format precision";
+			precision = 0;
+			while ( is_digit(at(x)) )
+				precision = precision * 10 + (fmt[x++] - '0');
+		}
+		if ( at(x) && at(x) != '}' )
+			type = fmt[x++];
+		if ( at(x) != '}' )
+			throw "invalid format spec";
+		return x + 1;
+	}
+
+	//////////////////////////////////////////////////////////////
+	// Is this spec applicable to an argument of type t?
+	//////////////////////////////////////////////////////////////
+
+	constexpr bool
+	valid_for(FormatArg::Type t) const {
+		using Type = FormatArg::Type;
+		auto is_int = [](char ch) {
+			return ch == 'd' || ch == 'x' || ch == 'X' || ch == 'o' || ch == 'b' || ch == 'B';
+		};
+		auto is_float = [](char ch) {
+			return ch == 'f' || ch == 'F' || ch == 'e' || ch == 'E' || ch == 'g' || ch == 'G';
+		};
+
+		switch ( t ) {
+		case Type::Int:
+		case Type::Uint:
+			return (!type || is_int(type) || type == 'c') && precision < 0;
+		case Type::Double:
+			return !type || is_float(type);
+		case Type::Bool:
+			return (!type || type == 's' || is_int(type)) && precision < 0;
+		case Type::Char:
+			return (!type || type == 'c' || is_int(type)) && precision < 0;
+		case Type::String:
+			return (!type || type == 's') && sign == '-' && !alt && !zero;
+		case Type::Pointer:
+			return (!type || type == 'p') && precision < 0 && sign == '-' && !alt;
+		}
+		return false;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////
+// Check a format string against argument types (throws if invalid,
+// which is a compile error when called from a consteval context)
+//////////////////////////////////////////////////////////////////////
+
+constexpr void
+format_check(std::string_view fmt,const FormatArg::Type *types,size_t nargs) {
+	size_t next = 0;
+	bool autof = false, manualf = false;
+
+	for ( size_t x=0; x<fmt.size(); ++x ) {
+		if ( fmt[x] == '}' ) {
+			if ( x + 1 < fmt.size() && fmt[x+1] == '}' ) {
+				++x;
+				continue;
+			}
+			throw "unmatched '}' in format string";
+		}
+		if ( fmt[x] != '{' )
+			continue;
+		if ( x + 1 < fmt.size() && fmt[x+1] == '{' ) {
+			++x;
+			continue;
+		}
+
+		FormatSpec spec;
+		size_t argx;
+
+		x = spec.parse(fmt,x+1) - 1;
+		if ( spec.arg >= 0 ) {
+			manualf = true;
+			argx = size_t(spec.arg);
+		} else	{
+			autof = true;
+			argx = next++;
+		}
+		if ( autof && manualf )
+			throw "cannot mix automatic and manual argument indexes";
+		if ( argx >= nargs )
+			throw "format string refers to a missing argument";
+		if ( !spec.valid_for(types[argx]) )
+			throw "format spec does not match the argument type";
+	}
+	if ( autof && next != nargs )
+		throw "too many arguments for format string";
+}
+
+//////////////////////////////////////////////////////////////////////
+// A format string, checked at compile time for the argument types
+//////////////////////////////////////////////////////////////////////
+
+template <typename... Args>
+class FormatString {
+	std::string_view	fmt;
+
+public:	template <typename S>
+	requires std::is_convertible_v<const S&,std::string_view>
+	consteval FormatString(const S& s) : fmt(s) {
+		const FormatArg::Type types[] = { FormatArg::type_of<Args>()..., FormatArg::Type::Int };
+
+		format_check(fmt,types,sizeof...(Args));
+	}
+
+	constexpr std::string_view view() const { return fmt; }
+};
+
+//////////////////////////////////////////////////////////////////////
+// Output buffer: on the stack, unless the text outgrows it
+//////////////////////////////////////////////////////////////////////
+
+class FormatBuffer {
+	char		local[512];
+	char		*buf = local;
+	size_t		len = 0;
+	size_t		cap = sizeof local;
+	std::string	heap;			// Used after outgrowing local
+
+	void grow(size_t need);
+
+public:	FormatBuffer() {}
+	FormatBuffer(const FormatBuffer&) = delete;
+	FormatBuffer& operator=(const FormatBuffer&) = delete;
+
+	void append(const char *str,size_t n) {
+		if ( len + n > cap )
+			grow(len + n);
+		std::char_traits<char>::copy(buf + len,str,n);
+		len += n;
+	}
+	void append(char ch,size_t n=1) {
+		if ( len + n > cap )
+			grow(len + n);
+		std::char_traits<char>::assign(buf + len,n,ch);
+		len += n;
+	}
+
+	const char *data() const { return buf; }
+	size_t size() const { return len; }
+	void clear() { len = 0; }
+};
+
+void format_to(FormatBuffer& out,std::string_view fmt,const FormatArg *args,size_t nargs);
+
+#endif // FORMAT_HPP
+
+// End format.hpp
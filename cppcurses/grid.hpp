@@ -0,0 +1,119 @@
+//////////////////////////////////////////////////////////////////////
+// grid.hpp -- C++ NCurses Class Library - Virtual table widget
+// Date: Sun Oct 18 04:10:51 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#ifndef GRID_HPP
+#define GRID_HPP
+
+#include <stdint.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <cppcurses/cppcurses.hpp>
+
+//////////////////////////////////////////////////////////////////////
+// A cell, as filled in by a Grid's data source
+//////////////////////////////////////////////////////////////////////
+
+struct GridCell {
+	FormatBuffer	text;
+	Style		style;
+
+	void assign(std::string_view str) { text.append(str.data(),str.size()); }
+
+	template <typename... Args>
+	void print(FormatString<std::type_identity_t<Args>...> format,const Args&... args) {
+		const FormatArg argv[] = { FormatArg(args)..., FormatArg() };
+
+		format_to(text,format.view(),argv,sizeof...(Args));
+	}
+};
+
+//////////////////////////////////////////////////////////////////////
+// A table of any number of rows, whose cells come from a data source
+// callback. Only the rows in view are ever asked for: render() calls
+// the source for the rows that came into view or were invalidated,
+// and draws only those, so the cost of a frame depends on the window
+// size, not the number of rows.
+//
+// The column titles (if any) and the first freeze() rows stay at the
+// top. Scrolling by less than a page scrolls the window (so that the
+// terminal can scroll its region) and fetches only the exposed rows.
+// Columns of width 0 are sized to the widest text seen in them. The
+// widths are cached: they only grow, until autosize().
+//////////////////////////////////////////////////////////////////////
+
+class Grid {
+public:	struct Column {
+		std::string	title;
+		short		width = 0;	// 0 sizes the column to its text
+		bool		right = false;	// Right aligned
+	};
+
+	typedef void (*Source)(void *arg,uint64_t row,unsigned col,GridCell& cell);
+
+	struct Stats {
+		uint64_t	cells = 0;	// Cells fetched from the source
+		uint64_t	rows_drawn = 0;	// Rows drawn by render()
+		uint64_t	scrolls = 0;	// render() calls that scrolled
+		uint64_t	redraws = 0;	// render() calls that redrew all
+	};
+
+private:
+	Window		*w;
+	std::vector<Column> columns;
+	std::vector<short> widths;		// Column widths in use
+	Source		source;
+	void		*arg;
+	uint64_t	nrows = 0;		// Rows in the source
+	uint64_t	frozen = 0;		// Rows fixed at the top
+	uint64_t	top = 0;		// First scrolling row in view
+	uint64_t	shown_top = 0;		// top as of the last render()
+	int		shown_rows = -1, shown_cols = -1; // Window size then
+	bool		redrawf = true;
+	Style		titles;
+	std::vector<bool> dirty;		// Screen rows to draw
+	std::vector<std::string> texts;		// Fetched cells of the screen rows
+	std::vector<Style> styles;
+	GridCell	cell;
+	Stats		statistics;
+
+	int title_rows() const;
+	int body_rows();
+	uint64_t row_at(int r) const;		// Source row shown in screen row r
+	void fetch(int r,uint64_t row,bool& grown);
+	void draw(int r,uint64_t row,int cols);
+
+public:	Grid(Window *parent,short y,short x,short nlines,short ncols,std::vector<Column> columns,
+		Source source,void *arg,bool border=false);
+	~Grid();
+	Grid(const Grid&) = delete;
+	Grid& operator=(const Grid&) = delete;
+
+	Window *window() { return w; }
+
+	Grid& rows(uint64_t n);				// The source now has n rows
+	uint64_t rows() const { return nrows; }
+	Grid& freeze(uint64_t n);			// Keep the first n rows in view
+	Grid& title_style(const Style& style);
+	Grid& invalidate(uint64_t row);			// The source changed a row
+	Grid& invalidate();				// .. or every row
+	Grid& autosize();				// Measure width 0 columns anew
+
+	Grid& scroll_to(uint64_t row);			// First scrolling row in view
+	Grid& scroll_up(uint64_t n=1);
+	Grid& scroll_down(uint64_t n=1);
+	Grid& page_up();
+	Grid& page_down();
+	uint64_t first_row() const { return frozen + top; }
+
+	Grid& render();
+	const Stats& stats() const { return statistics; }
+};
+
+#endif // GRID_HPP
+
+// End grid.hpp
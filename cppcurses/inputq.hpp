@@ -0,0 +1,120 @@
+//////////////////////////////////////////////////////////////////////
+// inputq.hpp -- C++ NCurses Class Library - Input event queue
+// Date: Sun Oct 18 04:02:18 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#ifndef INPUTQ_HPP
+#define INPUTQ_HPP
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cppcurses/cppcurses.hpp>
+
+//////////////////////////////////////////////////////////////////////
+// An input event: a character, a key, a mouse event or a resize
+//////////////////////////////////////////////////////////////////////
+
+struct InputEvent {
+	enum class Type : uint8_t {
+		Char,		// ch
+		Key,		// key
+		Mouse,		// y, x, button, action
+		Resize,		// y, x are the new rows and columns
+	};
+
+	enum Mods : uint8_t {
+		Shift = 1,
+		Alt = 2,	// Also ESC followed by a character
+		Ctrl = 4,
+	};
+
+	enum class Action : uint8_t {
+		Press,
+		Release,
+		Motion,
+	};
+
+	Type		type = Type::Char;
+	Key		key = Key::Event;	// Type::Key (Key::Mouse, Key::Resize for those)
+	uint32_t	ch = 0;			// Type::Char: Unicode code point
+	short		y = 0, x = 0;		// Mouse cell, or new terminal size
+	uint8_t		button = 0;		// Mouse: 1-3, 4/5 wheel up/down, 0 none
+	Action		action = Action::Press;
+	uint8_t		mods = 0;		// Mods bits
+};
+
+//////////////////////////////////////////////////////////////////////
+// An input thread that reads the terminal and publishes InputEvents
+// to a bounded lock free ring, which any number of threads consume.
+//
+// The thread reads and decodes the terminal itself, using the key
+// sequences from terminfo, so that it never calls into curses (which
+// is single threaded). While an InputQueue exists, do not use
+// Window::getch(), readch() or wait_event(). A Resize event must be
+// applied on the curses thread with CppCurses::resize(ev.y,ev.x).
+// Consumers blocked in pop() when the queue is destroyed return false,
+// and the destructor waits for them to return; no pop() may start
+// once the destructor has begun.
+// Curses' typeahead check is off meanwhile, so that pending input
+// never cuts an update short.
+// Construct and destroy the queue on the curses thread.
+//////////////////////////////////////////////////////////////////////
+
+class InputQueue {
+public:	struct Stats {
+		uint64_t	events = 0;	// Events published
+		uint64_t	dropped = 0;	// Events dropped (ring full)
+	};
+
+private:
+	struct Slot {
+		std::atomic<uint32_t> seq;
+		InputEvent	ev;
+	};
+
+	CppCurses	&curses;
+	std::unique_ptr<Slot[]> slots;
+	uint32_t	mask;
+	alignas(64) std::atomic<uint32_t> enqueue_pos{0};
+	alignas(64) std::atomic<uint32_t> dequeue_pos{0};
+	alignas(64) std::atomic<uint32_t> seq{0};	// Futex: bumped per event
+	std::atomic<uint32_t> waiters{0};		// Threads waiting on seq
+	std::atomic<bool> stopf{false};
+	std::atomic<uint64_t> events{0};
+	std::atomic<uint64_t> dropped{0};
+
+	int		ttyfd;				// Copied from curses
+	int		sigfd;
+	int		stopfd = -1;			// eventfd(2) to stop the thread
+	int		escdelay;			// ms to wait after ESC
+	bool		mousef;
+	std::vector<std::pair<std::string,Key>> bindings;
+	std::thread	thread;
+
+	void run();
+	size_t decode(const char *buf,size_t n,bool final);
+	size_t decode_key(const char *buf,size_t n,bool final,InputEvent& ev,bool& valid);
+	bool push(const InputEvent& ev);
+	void wake();
+
+public:	InputQueue(CppCurses& curses,unsigned capacity=256,bool mouse=true);
+	~InputQueue();
+	InputQueue(const InputQueue&) = delete;
+	InputQueue& operator=(const InputQueue&) = delete;
+
+	bool try_pop(InputEvent& ev);		// false if empty
+	bool pop(InputEvent& ev);		// Blocks: false once stopped
+	bool pop(InputEvent& ev,int ms);	// false on timeout
+	Stats stats() const;
+};
+
+#endif // INPUTQ_HPP
+
+// End inputq.hpp
@@ -0,0 +1,131 @@
+//////////////////////////////////////////////////////////////////////
+// layout.hpp -- C++ NCurses Class Library - Split layouts
+// Date: Sun Oct 18 04:48:32 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#ifndef LAYOUT_HPP
+#define LAYOUT_HPP
+
+#include <stdint.h>
+#include <limits.h>
+
+#include <vector>
+
+#include <cppcurses/cppcurses.hpp>
+
+//////////////////////////////////////////////////////////////////////
+// A tree of nested splits, which gives rectangles to windows. A node
+// splits its rectangle (less its padding) among its children, stacked
+// (Split::Rows) or side by side (Split::Columns). A child is of fixed
+// size, or takes a share (by weight) of what the fixed children leave,
+// and either may be held to a minimum and maximum.
+//
+// The geometry is cached: apply() only sizes the children of the
+// nodes whose rectangle or children changed, and only descends into
+// the subtrees that need it. A window is placed in place (see
+// Window::place()) when its node's rectangle changes, and is hidden
+// while the rectangle is empty (then shown again at its place in the
+// stack, see Window::unhide()).
+//
+//	Layout lay(Layout::Split::Columns);
+//	Layout::Node side = lay.add(lay.root(),Layout::fixed(30));
+//	Layout::Node body = lay.add(lay.root(),Layout::flex(1,20));
+//
+//	lay.attach(side,w->border_window(0,0,3,3)).pad(side,1);
+//	lay.attach(body,w->new_window(0,0,1,1));
+//	lay.apply(rows,cols);
+//	w->on_resize(Layout::resized,&lay);	// Follow the terminal
+//////////////////////////////////////////////////////////////////////
+
+class Layout {
+public:	typedef uint32_t Node;			// root() is 0
+
+	enum class Split : uint8_t {
+		Rows,				// Children stacked top to bottom
+		Columns,			// .. side by side
+	};
+
+	struct Size {
+		short		cells = 0;	// Fixed size (0 takes a share)
+		uint16_t	weight = 1;	// Share of the space left
+		short		min = 0;	// Limits of either
+		short		max = SHRT_MAX;
+	};
+
+	struct Rect {
+		short		y = 0, x = 0;
+		short		nlines = 0, ncols = 0;
+
+		bool operator==(const Rect& other) const = default;
+	};
+
+	struct Stats {
+		uint64_t	passes = 0;	// apply() calls
+		uint64_t	visits = 0;	// Nodes descended into
+		uint64_t	sized = 0;	// .. whose children were sized
+		uint64_t	placed = 0;	// Windows placed
+	};
+
+private:
+	static constexpr uint32_t none = UINT32_MAX;
+
+	struct Item {
+		Size		size;
+		Split		split = Split::Rows;
+		short		pad = 0;	// Inset of the children
+		short		extent = 0;	// Size given along the parent's split
+		bool		sizedf = true;	// Children to be sized
+		bool		belowf = false;	// A descendant to be visited
+		bool		placef = false;	// Window to be placed
+		bool		hidf = false;	// Window hidden (empty rectangle)
+		uint32_t	parent = none;
+		uint32_t	first = none, last = none, next = none;
+		Rect		rect;		// As last applied
+		Window		*w = nullptr;
+	};
+
+	std::vector<Item> items;
+	Stats		statistics;
+
+	void mark(Node n);
+	void distribute(Item& item,int space);
+	void layout(Node n,const Rect& r);
+	void place(Item& item);
+
+public:	Layout(Split split=Split::Rows);
+
+	static constexpr Size fixed(short cells) {
+		Size size;
+
+		size.cells = cells;
+		size.weight = 0;		// fixed(0) is empty
+		return size;
+	}
+	static constexpr Size flex(uint16_t weight=1,short min=0,short max=SHRT_MAX) {
+		Size size;
+
+		size.weight = weight;
+		size.min = min;
+		size.max = max;
+		return size;
+	}
+
+	Node root() const { return 0; }
+	Node add(Node parent,Size size,Split split=Split::Rows);	// Last child
+	Layout& size(Node n,Size size);
+	Layout& split(Node n,Split split);
+	Layout& pad(Node n,short cells);		// 1 within a border_window()
+	Layout& attach(Node n,Window *w);		// nullptr detaches
+	const Rect& rect(Node n) const { return items[n].rect; }
+	size_t nodes() const { return items.size(); }
+
+	bool apply(short rows,short cols);		// true if a window was placed
+	bool apply(const Rect& r);
+	static void resized(void *arg,Window& w,short rows,short cols);	// For on_resize()
+
+	const Stats& stats() const { return statistics; }
+};
+
+#endif // LAYOUT_HPP
+
+// End layout.hpp
@@ -0,0 +1,106 @@
+//////////////////////////////////////////////////////////////////////
+// logwin.hpp -- C++ NCurses Class Library - Scrolling log window
+// Date: Sun Oct 18 04:07:56 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#ifndef LOGWIN_HPP
+#define LOGWIN_HPP
+
+#include <stdint.h>
+
+#include <memory>
+#include <string_view>
+
+#include <cppcurses/cppcurses.hpp>
+
+//////////////////////////////////////////////////////////////////////
+// A window showing the tail of a log, with scrollback. Lines are kept
+// in a ring of fixed capacity, and their text in a fixed size arena,
+// so that appending never allocates: the oldest lines are dropped to
+// make room.
+//
+// Appending only stores the line. render() brings the window up to
+// date (call it once per frame, before the refresh): when the view
+// moved by fewer lines than the window height, the window is
+// scrolled (so that the terminal can scroll its region) and only the
+// newly exposed lines are drawn. Lines wider than the window are
+// clipped, and control characters are shown as spaces.
+//////////////////////////////////////////////////////////////////////
+
+class LogWindow {
+public:	struct Stats {
+		uint64_t	appended = 0;	// Lines appended
+		uint64_t	evicted = 0;	// Oldest lines dropped for room
+		uint64_t	scrolls = 0;	// render() calls that scrolled
+		uint64_t	redraws = 0;	// render() calls that redrew all
+		uint64_t	lines_drawn = 0; // Lines drawn by render()
+	};
+
+private:
+	struct Line {
+		uint64_t	pos;		// Arena position (pos % arena_size)
+		uint32_t	len;
+		Window::wattr_t	attrs;
+		Window::colpair_t pair;
+	};
+
+	static constexpr uint32_t max_line = 4096;	// Longer lines are truncated
+
+	Window		*w;
+	std::unique_ptr<Line[]> lines;
+	uint64_t	line_mask;
+	std::unique_ptr<char[]> arena;
+	uint64_t	arena_size;
+	uint64_t	wpos = 0;		// Arena write position
+	uint64_t	first = 0;		// Oldest line
+	uint64_t	next = 0;		// Line number of the next append
+	uint64_t	back = 0;		// Lines scrolled back from the tail
+	uint64_t	shown_top = 0;		// Line shown in row 0 by render()
+	uint64_t	shown_n = 0;		// Rows showing lines
+	int		shown_rows = -1, shown_cols = -1; // Window size then
+	bool		redrawf = true;
+	Style		cur_style;
+	Stats		statistics;
+
+	void add_line(const char *text,size_t len);
+	void draw_line(short row,uint64_t seq,int cols);
+	uint64_t rows();
+
+public:	LogWindow(Window *parent,short y,short x,short nlines,short ncols,
+		size_t max_lines=10000,size_t arena_bytes=1024*1024,bool border=false);
+	~LogWindow();
+	LogWindow(const LogWindow&) = delete;
+	LogWindow& operator=(const LogWindow&) = delete;
+
+	Window *window() { return w; }
+
+	LogWindow& style(const Style& style) { cur_style = style; return *this; }
+	LogWindow& append(std::string_view text);	// One line per '\n'
+
+	template <typename... Args>
+	LogWindow& print(FormatString<std::type_identity_t<Args>...> format,const Args&... args) {
+		const FormatArg argv[] = { FormatArg(args)..., FormatArg() };
+		FormatBuffer buf;
+
+		format_to(buf,format.view(),argv,sizeof...(Args));
+		return append(std::string_view(buf.data(),buf.size()));
+	}
+
+	LogWindow& scroll_up(uint64_t n=1);		// Toward older lines
+	LogWindow& scroll_down(uint64_t n=1);		// Toward the tail
+	LogWindow& page_up();
+	LogWindow& page_down();
+	LogWindow& scroll_to_end();
+	bool at_end() const { return back == 0; }	// Following the tail
+	LogWindow& redraw() { redrawf = true; return *this; }
+
+	uint64_t size() const { return next - first; }	// Lines held
+	bool line(uint64_t n,std::string_view& text) const; // n'th line held (0 is oldest)
+
+	LogWindow& render();
+	const Stats& stats() const { return statistics; }
+};
+
+#endif // LOGWIN_HPP
+
+// End logwin.hpp
@@ -0,0 +1,154 @@
+//////////////////////////////////////////////////////////////////////
+// renderq.hpp -- C++ NCurses Class Library - Render command queue
+// Date: Sun Oct 18 03:57:55 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#ifndef RENDERQ_HPP
+#define RENDERQ_HPP
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <cppcurses/cppcurses.hpp>
+
+//////////////////////////////////////////////////////////////////////
+// Curses is single threaded. A RenderQueue lets other threads draw:
+// they post commands against Window pointers, and the render thread
+// applies them in batches with render(), which updates the screen
+// at most once per batch.
+//
+// Each posting thread gets its own single producer ring, so posting
+// takes no lock and never waits for the render thread or terminal
+// I/O. When a thread's ring is full, the command is dropped and the
+// post returns false (see stats().dropped). Commands from one thread
+// are applied in order; there is no ordering between threads.
+//
+// Windows must outlive the commands posted against them.
+//////////////////////////////////////////////////////////////////////
+
+class RenderQueue {
+public:	struct Stats {
+		uint64_t	posted = 0;	// Commands posted
+		uint64_t	dropped = 0;	// Commands dropped (ring full)
+		uint64_t	applied = 0;	// Commands applied by drain()
+		uint64_t	batches = 0;	// drain() calls that applied any
+		unsigned	producers = 0;	// Rings in use
+	};
+
+private:
+	//////////////////////////////////////////////////////////////
+	// One 64 byte ring slot. Text and cells longer than data[]
+	// continue in the following slots, 64 bytes per slot.
+	//////////////////////////////////////////////////////////////
+
+	struct alignas(64) Cmd {
+		enum Op : uint8_t {
+			Move,
+			Text,
+			Blit,
+			AttrSet,
+			Erase,
+			Clear,
+			Call,
+		};
+
+		Window		*win;
+		uint32_t	len;		// Payload bytes
+		short		y, x;		// Text: y < 0 is at the cursor
+		Op		op;
+		union {
+			char		data[40];
+			struct {
+				Window::wattr_t	  attrs;
+				Window::colpair_t pair;
+			}		attr;
+			struct {
+				void	(*fn)(void *arg);
+				void	*arg;
+			}		call;
+		};
+	};
+
+	static_assert(sizeof(Cmd) == 64);
+
+	//////////////////////////////////////////////////////////////
+	// A single producer, single consumer ring of slots
+	//////////////////////////////////////////////////////////////
+
+	struct Ring {
+		alignas(64) std::atomic<uint32_t> tail{0};	// Written by the producer
+		uint32_t	head_cache = 0;			// Producer's copy of head
+		std::atomic<uint64_t> posted{0};
+		std::atomic<uint64_t> dropped{0};
+		alignas(64) std::atomic<uint32_t> head{0};	// Written by the consumer
+		alignas(64) std::atomic<bool> owned{false};	// Claimed by a thread
+		std::unique_ptr<Cmd[]> slots;
+		uint32_t	mask;
+
+		Ring(uint32_t nslots) : slots(new Cmd[nslots]), mask(nslots-1) {}
+	};
+
+	static constexpr unsigned max_rings = 256;
+
+	CppCurses	&curses;
+	uint64_t	id;				// Unique, never reused
+	uint32_t	nslots;				// Per ring (power of 2)
+	std::mutex	mutex;				// Ring registration
+	std::atomic<Ring*> rings[max_rings] = {};
+	std::atomic<unsigned> nrings{0};
+	uint64_t	applied = 0, batches = 0;	// Render thread only
+	std::vector<char> scratch;			// Render thread only
+	std::vector<Cell> cells;			// Render thread only
+
+	friend struct RenderProducer;
+
+	Ring *ring();
+	Ring *claim();
+	Cmd *reserve(Ring *r,uint32_t n);
+	void commit(Ring *r,uint32_t n);
+	bool post(Window *w,Cmd::Op op,short y,short x,const void *data,size_t len);
+	const char *payload(Ring *r,uint32_t h,const Cmd& cmd);
+	void apply(Ring *r,uint32_t h,const Cmd& cmd);
+	static uint32_t slots_of(size_t len);
+
+public:	RenderQueue(CppCurses& curses,unsigned slots=1024);
+	~RenderQueue();
+	RenderQueue(const RenderQueue&) = delete;
+	RenderQueue& operator=(const RenderQueue&) = delete;
+
+	// Producers (any thread):
+	bool move(Window *w,short y,short x);
+	bool addstr(Window *w,std::string_view str);
+	bool mvaddstr(Window *w,short y,short x,std::string_view str);
+	bool blit(Window *w,short y,short x,std::span<const Cell> cells);
+	bool attr_set(Window *w,Attrs attrs,Window::colpair_t pair=0);
+	bool style(Window *w,const Style& style) { return attr_set(w,style.attrs,style.pair); }
+	bool erase(Window *w);
+	bool clear(Window *w);
+	bool call(void (*fn)(void *arg),void *arg);	// Run fn(arg) on the render thread
+
+	template <typename... Args>			// Formatted by the caller's thread
+	bool mvprint(Window *w,short y,short x,FormatString<std::type_identity_t<Args>...> format,const Args&... args) {
+		const FormatArg argv[] = { FormatArg(args)..., FormatArg() };
+		FormatBuffer buf;
+
+		format_to(buf,format.view(),argv,sizeof...(Args));
+		return mvaddstr(w,y,x,std::string_view(buf.data(),buf.size()));
+	}
+
+	// Render thread:
+	size_t drain();				// Apply pending commands
+	size_t render();			// drain() and update the screen
+	Stats stats();
+};
+
+#endif // RENDERQ_HPP
+
+// End renderq.hpp
@@ -0,0 +1,74 @@
+//////////////////////////////////////////////////////////////////////
+// screendiff.hpp -- C++ NCurses Class Library - Diffing screen renderer
+// Date: Sun Oct 18 04:32:15 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#ifndef SCREENDIFF_HPP
+#define SCREENDIFF_HPP
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+// An alternative to doupdate() (see CppCurses::diff_render()). The
+// panels are still composed by update_panels(), but the terminal is
+// written by the library: the rows curses marks as changed are read
+// from the composed screen into a packed row of 64 bit cells
+// (character, attributes and colour pair), which is compared with
+// the library's copy of the terminal (the front buffer) using SSE2
+// or AVX2 (chosen at run time, with a scalar fallback). Only the
+// changed spans are written, with the fewest cursor moves and SGR
+// changes, and the frame goes out in a single write().
+//
+// The output is ECMA-48 (xterm compatible): absolute and relative
+// cursor moves, SGR attributes, 8/16/256 (or direct) colours, and
+// the DEC line drawing set for A_ALTCHARSET. Terminal line scrolling
+// is not used, so scrolled regions are rewritten.
+//////////////////////////////////////////////////////////////////////
+
+class ScreenDiff {
+public:	struct Stats {
+		uint64_t	frames = 0;		// update() calls
+		uint64_t	rows_compared = 0;	// Touched rows compared
+		uint64_t	rows_changed = 0;	// .. that differed
+		uint64_t	cells_written = 0;
+		uint64_t	repaints = 0;		// Full screen repaints
+	};
+
+private:
+	int		fd;				// Terminal output
+	int		nrows = 0, ncols = 0;		// Size of front
+	std::vector<uint64_t> front;			// As on the terminal
+	std::vector<uint64_t> back;			// One composed row
+	std::vector<char> scratch;			// cchar_t row buffer
+	std::string	out;				// The frame's output
+	bool		fullf = true;			// Repaint everything
+	int		cur_y = -1, cur_x = -1;		// Terminal cursor (-1 unknown)
+	uint64_t	cur_sgr = 0;			// Terminal attributes and pair
+	bool		cur_acs = false;		// Line drawing set selected
+	bool		syncf = false;			// Wrap in DEC 2026 set/reset
+	Stats		statistics;
+
+	void read_row(int y);
+	void put_row(int y,int first,int last);
+	void put_move(int y,int x);
+	void put_sgr(uint64_t cell);
+	void put_char(uint64_t cell);
+	void flush();
+
+public:	ScreenDiff(int fd);
+	ScreenDiff(const ScreenDiff&) = delete;
+	ScreenDiff& operator=(const ScreenDiff&) = delete;
+
+	void invalidate() { fullf = true; }		// Repaint at the next update
+	void sync(bool on) { syncf = on; }		// Synchronized updates
+	void update();					// In place of doupdate()
+	const Stats& stats() const { return statistics; }
+	static const char *simd();			// Row compare in use
+};
+
+#endif // SCREENDIFF_HPP
+
+// End screendiff.hpp
@@ -0,0 +1,109 @@
+//////////////////////////////////////////////////////////////////////
+// trace.hpp -- C++ NCurses Class Library - Hot path tracing
+// Date: Sun Oct 18 04:22:52 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <atomic>
+
+//////////////////////////////////////////////////////////////////////
+// Tracing spans, compiled in only with -DCPPCURSES_TRACE (make
+// TRACE=1). Without it, CPPCURSES_SPAN() expands to nothing.
+//
+// A span records its name, start and duration in the calling
+// thread's ring of events when it goes out of scope: two clock reads
+// and a buffer write, with no lock and no allocation (a thread takes
+// a ring on its first span). The rings keep the latest events, the
+// oldest being overwritten. dump() writes the events of every thread
+// as Chrome trace event JSON, for chrome://tracing or Perfetto
+// (CppCurses::trace_to() does this at close()).
+//
+// Span names must be string literals (or otherwise outlive the dump).
+//////////////////////////////////////////////////////////////////////
+
+class Trace {
+public:	static constexpr unsigned ring_events = 16384;	// Per thread (power of 2)
+	static constexpr unsigned max_rings = 256;	// Threads traced at once
+
+	struct Event {
+		std::atomic<const char*> name;
+		std::atomic<int64_t> ts;		// CLOCK_MONOTONIC ns
+		std::atomic<int64_t> dur;		// ns
+		std::atomic<int>	tid;
+	};
+
+	struct Ring {
+		std::atomic<uint64_t> pos{0};		// Events ever recorded
+		std::atomic<bool> owned{false};		// Claimed by a thread
+		int		tid = 0;		// Owner's thread id
+		Event		events[ring_events];
+	};
+
+private:
+	static inline thread_local Ring *local = nullptr;
+
+	static Ring *claim();
+
+public:	static constexpr bool enabled() {
+#ifdef CPPCURSES_TRACE
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	static int64_t now() {
+		timespec ts;
+
+		clock_gettime(CLOCK_MONOTONIC,&ts);
+		return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+	}
+
+	static void record(const char *name,int64_t begin,int64_t end) {
+		Ring *r = local ? local : claim();
+
+		if ( !r )
+			return;				// All rings taken
+
+		uint64_t p = r->pos.load(std::memory_order_relaxed);
+		Event& ev = r->events[p & (ring_events - 1)];
+
+		ev.name.store(name,std::memory_order_relaxed);
+		ev.ts.store(begin,std::memory_order_relaxed);
+		ev.dur.store(end - begin,std::memory_order_relaxed);
+		ev.tid.store(r->tid,std::memory_order_relaxed);
+		r->pos.store(p + 1,std::memory_order_release);
+	}
+
+	static size_t dump(FILE *fp);			// Events written
+	static size_t dump(const char *path);
+	static void clear();				// Forget the events so far
+};
+
+class TraceSpan {
+	const char	*name;
+	int64_t		begin;
+
+public:	TraceSpan(const char *name) : name(name), begin(Trace::now()) {}
+	~TraceSpan() { Trace::record(name,begin,Trace::now()); }
+	TraceSpan(const TraceSpan&) = delete;
+	TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#ifdef CPPCURSES_TRACE
+#define CPPCURSES_SPAN_(name,line)	TraceSpan cppcurses_span_##line(name)
+#define CPPCURSES_SPAN__(name,line)	CPPCURSES_SPAN_(name,line)
+#define CPPCURSES_SPAN(name)		CPPCURSES_SPAN__(name,__LINE__)
+#else
+#define CPPCURSES_SPAN(name)		((void)0)
+#endif
+
+#endif // TRACE_HPP
+
+// End trace.hpp
@@ -8,7 +8,11 @@
 
 #include <stdint.h>
 #include "cppcurses.hpp"
+#include "format.hpp"
 #include <string>
+#include <span>
+#include <utility>
+#include <vector>
 
 class CppCurses;
 
@@ -119,62 +123,233 @@ enum class Key {
 	Event,		// We were interrupted by an event
 };
 
+//////////////////////////////////////////////////////////////////////
+// Attributes (the bits are the curses A_* values, which is checked
+// in window.cpp). Attribute strings can be parsed at compile time:
+//
+//	w->attr_on("BR"_attr);
+//
+// where an unknown attribute character is a compile error.
+//////////////////////////////////////////////////////////////////////
+
+struct Attrs {
+	enum : uint32_t {
+		Normal = 0,			// 'N'
+		Standout = 1u << 16,		// 'S'
+		Underline = 1u << 17,		// 'U'
+		Reverse = 1u << 18,		// 'R'
+		Blink = 1u << 19,		// 'b'
+		Dim = 1u << 20,			// 'D'
+		Bold = 1u << 21,		// 'B'
+		Altcharset = 1u << 22,		// 'A'
+	};
+
+	uint32_t	bits = 0;
+
+	constexpr Attrs() {}
+	constexpr explicit Attrs(uint32_t bits) : bits(bits) {}
+
+	constexpr Attrs operator|(Attrs other) const { return Attrs(bits | other.bits); }
+	constexpr bool operator==(const Attrs& other) const = default;
+
+	static constexpr uint32_t
+	bit(char ch) {
+		switch ( ch ) {
+		case 'N':	return Normal;
+		case 'S':	return Standout;
+		case 'U':	return Underline;
+		case 'R':	return Reverse;
+		case 'b':	return Blink;
+		case 'D':	return Dim;
+		case 'B':	return Bold;
+		case 'A':	return Altcharset;
+		default:	throw "unknown attribute character";
+		}
+	}
+
+	static constexpr Attrs
+	parse(const char *str,size_t n) {
+		uint32_t bits = 0;
+
+		for ( size_t x=0; x<n; ++x )
+			bits |= bit(str[x]);
+		return Attrs(bits);
+	}
+};
+
+consteval Attrs
+operator""_attr(const char *str,size_t n) {
+	return Attrs::parse(str,n);
+}
+
+//////////////////////////////////////////////////////////////////////
+// A 24-bit colour. On terminals without direct colour, it is
+// approximated by the nearest colour of the terminal's palette.
+//////////////////////////////////////////////////////////////////////
+
+struct Rgb {
+	uint8_t		r = 0;
+	uint8_t		g = 0;
+	uint8_t		b = 0;
+
+	constexpr Rgb() {}
+	constexpr Rgb(uint8_t r,uint8_t g,uint8_t b) : r(r), g(g), b(b) {}
+	constexpr explicit Rgb(uint32_t rgb) : r(rgb >> 16), g(rgb >> 8), b(rgb) {}
+
+	constexpr uint32_t value() const { return uint32_t(r) << 16 | uint32_t(g) << 8 | b; }
+};
+
+struct Style;
+struct Cell;
+class WindowHandle;
+
+enum class Event {
+	Timeout,	// The wait timed out
+	Input,		// Terminal input is pending
+	Resize,		// Terminal was resized (SIGWINCH)
+};
+
+enum class Border : uint8_t {	// Frame of a border_window()
+	Single,		// Line drawing characters
+	Double,
+	Heavy,
+	Rounded,	// Single, with rounded corners (Unicode locales)
+	Ascii,		// +, - and |
+};
+
 class Window {
 public:
 	typedef short colpair_t;	// Local definition of colour pair
 	typedef uint32_t wattr_t;	// Local definition of attr_t
+	typedef void (*ResizeFunc)(void *arg,Window& w,short rows,short cols);
 
 protected:
 	friend CppCurses;
+	friend WindowHandle;
 
 	CppCurses	*main = nullptr;
 	void		*win = nullptr;
 	void		*sub = nullptr;
 	void		*panel = nullptr;
 	bool		mainf = false;
+	bool		borderf = false;	// From border_window()
+	bool		hiddenf = false;	// Panel hidden
+	bool		retiredf = false;	// In the pool (see CppCurses::retire())
+	bool		dirtyf = false;		// Drawn into since last update
+	unsigned long	synced_cells = 0;	// Accounted (see cells_synced())
+	short		lay_y = 0, lay_x = 0;	// Geometry asked for (0 = to the edge),
+	short		lay_lines = 0, lay_cols = 0; // .. reapplied on terminal resize
+	short		sub_y = 0, sub_x = 0;	// subwindow() asked for
+	short		sub_lines = 0, sub_cols = 0;
+	ResizeFunc	resize_fn = nullptr;	// on_resize()
+	void		*resize_arg = nullptr;
+	Border		border_kind = Border::Single; // Frame, retained:
+	wattr_t		border_attr = 0;
+	colpair_t	border_pair = 0;
+	std::string	border_text;		// Title
+	bool		framedf = false;	// Drawn as above, at this size:
+	short		framed_lines = 0, framed_cols = 0;
 	wattr_t		attr = 0;
 	colpair_t	colour_pair = 0;
 
-	static void init_maps(bool colour);
+	static void init_maps(bool colour,unsigned max_pairs);
 
 	Window(CppCurses *main,void *win);
 	Window(Window *parent,short y,short x,short nlines,short ncols);
 	void wposition();					// Internal
+	unsigned long account_sync();
 
 	static colpair_t to_colour(Colour bg,Colour fg);	// Colour pair
-	static void do_update();
+	void do_update();
+	void composite();
+	void changed();
+	void set_pair(colpair_t pair);
+	void frame();
+	void unframe();
+	void restyle(Border kind,wattr_t attrs,colpair_t pair);
+	void reshape(short y,short x,short nlines,short ncols);
+	void relayout(short rows,short cols);
+	void restack(bool first);
+	Window *recycle(short y,short x,short nlines,short ncols,bool border);
 
 public:	Window();
 	~Window();
 
+	static void *operator new(size_t size);		// From slabs of Windows
+	static void operator delete(void *p,size_t size);
+
 	Window& bgclear();
 	Window& erase();
 	Window& clear();
+	Window& clrtoeol();
+	Window& scroll(int n,short top=0,short bottom=-1);	// Up n lines (down if n < 0)
 	Window& refresh();
+	unsigned long cells_synced() const { return synced_cells; }	// With account_output()
 	
 	Window& move(int y,int x);
 	Window& addch(int ch);
 	Window& addstr(const char *str);
 	Window& addstr(const std::string& str);
+	Window& addstr(std::string_view str);		// UTF-8
 	Window& addgrstr(const char *str);
+	Window& blit(short y,short x,std::span<const Cell> cells);
+	Window& blit_rect(short y,short x,short nlines,short ncols,std::span<const Cell> cells);
 	size_t printf(const char *format,...) __attribute((format(printf,2,3)));
 	size_t mvprintf(int y,int x,const char *format,...) __attribute((format(printf,4,5)));
+	size_t vprint(std::string_view format,const FormatArg *args,size_t nargs);
+	size_t mvvprint(int y,int x,std::string_view format,const FormatArg *args,size_t nargs);
+
+	template <typename... Args>			// Type safe: "{}" formats
+	size_t print(FormatString<std::type_identity_t<Args>...> format,const Args&... args) {
+		const FormatArg argv[] = { FormatArg(args)..., FormatArg() };
+
+		return vprint(format.view(),argv,sizeof...(Args));
+	}
+	template <typename... Args>
+	size_t mvprint(int y,int x,FormatString<std::type_identity_t<Args>...> format,const Args&... args) {
+		const FormatArg argv[] = { FormatArg(args)..., FormatArg() };
+
+		return mvvprint(y,x,format.view(),argv,sizeof...(Args));
+	}
 
 	Window& colour(Colour fg,Colour bg);
+	Window& colour(int fg,int bg);		// Indexed colours
+	Window& colour(Rgb fg,Rgb bg);		// 24-bit colours
 	Window& fg(Colour fg);
 	Window& bg(Colour bg);
 	Window& attr_on(const char *attrs);
 	Window& attr_off(const char *attrs);
 	Window& attr_set(const char *attrs,colpair_t = 0);
+	Window& attr_on(Attrs attrs);
+	Window& attr_off(Attrs attrs);
+	Window& attr_set(Attrs attrs,colpair_t = 0);
+	Window& style(const Style& style);
+	colpair_t pair(Colour fg,Colour bg);	// Pair for a Cell or Style (valid until recycled)
+	colpair_t pair(int fg,int bg);
+	colpair_t pair(Rgb fg,Rgb bg);
+
+	static constexpr colpair_t
+	to_pair(Colour fg,Colour bg) {	// Pair of the 8 colour { fg,bg }
+		return colpair_t(short(bg) << 3 | short(fg));
+	}
 
 	Window *new_window(short y,short x,short nlines=0,short ncols=0);
 	Window *border_window(short y,short x,short nlines=0,short ncols=0);
+	WindowHandle make_window(short y,short x,short nlines=0,short ncols=0);	// Pooled
+	WindowHandle make_border_window(short y,short x,short nlines=0,short ncols=0);
 	Window& subwindow(short y,short x,short nlines=0,short ncols=0);
+	Window& border_style(Border kind);		// Frame of a border_window()
+	Window& border_style(const Style& style);	// .. its attributes and colours
+	Window& border_title(std::string_view title);	// .. text in its top edge
 	Window& hide();
-	Window& show();
+	Window& show();				// .. and raise to the top
+	Window& unhide();			// Show where it was in the stack
 	Window& top();
 	Window& bottom();
 	Window& move_window(short starty,short startx);
+	Window& resize(short nlines,short ncols);	// In place (0 = to the edge)
+	Window& place(short y,short x,short nlines,short ncols);	// Move and resize
+	Window& on_resize(ResizeFunc func,void *arg=nullptr);	// Terminal resized
 
 	Window& get_yx(int& y,int& x);
 	Window& orig(int& y,int& x);
@@ -186,11 +361,83 @@ public:	Window();
 	Window& cursor(bool on);
 
 	int getch();
-	int readch(unsigned ms=100);
+	int readch(unsigned ms=100);		// Blocks (ms is no longer used)
+	int readch_for(int ms);			// -1 after ms (< 0 blocks)
+	Event wait_event(int ms=-1);
 
 	Window& yield();
 
 	static bool is_supported(Key key);
+	static size_t clip_text(std::string_view text,int cols,int& width);	// Bytes fitting cols
+	static std::vector<std::pair<std::string,Key>> key_bindings();	// Terminal's key sequences
+	static int colours();			// Number of terminal colours
+};
+
+//////////////////////////////////////////////////////////////////////
+// Owns a Window from make_window() or make_border_window(). When the
+// handle goes, the window is hidden and kept for reuse by a later
+// window of the same size (see CppCurses::pool_limit()), rather than
+// deleted.
+//////////////////////////////////////////////////////////////////////
+
+class WindowHandle {
+	Window		*w = nullptr;
+
+public:	WindowHandle() {}
+	explicit WindowHandle(Window *w) : w(w) {}
+	WindowHandle(WindowHandle&& other) : w(other.w) { other.w = nullptr; }
+	~WindowHandle() { reset(); }
+	WindowHandle(const WindowHandle&) = delete;
+	WindowHandle& operator=(const WindowHandle&) = delete;
+
+	WindowHandle& operator=(WindowHandle&& other) {
+		if ( this != &other ) {
+			reset();
+			w = other.w;
+			other.w = nullptr;
+		}
+		return *this;
+	}
+
+	Window *get() const { return w; }
+	Window *operator->() const { return w; }
+	Window& operator*() const { return *w; }
+	explicit operator bool() const { return w != nullptr; }
+
+	Window *release() { Window *p = w; w = nullptr; return p; }	// Caller deletes it
+	void reset();							// Return it to the pool
+};
+
+//////////////////////////////////////////////////////////////////////
+// Attributes bundled with a colour pair, resolved at compile time
+// and applied with a single call:
+//
+//	static constexpr Style alert("BR"_attr,Colour::Yellow,Colour::Red);
+//	w->style(alert).addstr("ALERT");
+//////////////////////////////////////////////////////////////////////
+
+struct Style {
+	Attrs			attrs;
+	Window::colpair_t	pair = 0;	// 0 is the default colour pair
+
+	constexpr Style() {}
+	constexpr Style(Attrs attrs) : attrs(attrs) {}
+	constexpr Style(Colour fg,Colour bg) : pair(Window::to_pair(fg,bg)) {}
+	constexpr Style(Attrs attrs,Colour fg,Colour bg) : attrs(attrs), pair(Window::to_pair(fg,bg)) {}
+};
+
+//////////////////////////////////////////////////////////////////////
+// A screen cell: glyph, attributes and colour pair
+//////////////////////////////////////////////////////////////////////
+
+struct Cell {
+	uint32_t		ch = ' ';	// Glyph
+	Window::wattr_t		attrs = 0;	// Curses attributes
+	Window::colpair_t	pair = 0;	// Colour pair
+
+	constexpr Cell() {}
+	constexpr Cell(uint32_t ch,Window::wattr_t attrs=0,Window::colpair_t pair=0) : ch(ch), attrs(attrs), pair(pair) {}
+	constexpr Cell(uint32_t ch,const Style& style) : ch(ch), attrs(style.attrs.bits), pair(style.pair) {}
 };
 
 #endif // WINDOW_HPP
@@ -0,0 +1,276 @@
+//////////////////////////////////////////////////////////////////////
+// format.cpp -- C++ NCurses Class Library -- Formatting
+// Date: Sun Oct 18 03:47:18 2026   (C) ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include <charconv>
+#include <cmath>
+
+#include <cppcurses/format.hpp>
+
+//////////////////////////////////////////////////////////////////////
+// Move the text to the heap, once it outgrows the stack buffer
+//////////////////////////////////////////////////////////////////////
+
+void
+FormatBuffer::grow(size_t need) {
+	size_t ncap = cap * 2;
+
+	while ( ncap < need )
+		ncap *= 2;
+	if ( buf == local ) {
+		heap.resize(ncap);
+		memcpy(heap.data(),local,len);
+	} else	heap.resize(ncap);
+	buf = heap.data();
+	cap = ncap;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Append text padded to the spec's width. The text is split into a
+// prefix (sign, base) and a body, so that zero fill goes between.
+//////////////////////////////////////////////////////////////////////
+
+static void
+emit(FormatBuffer& out,const FormatSpec& spec,char defalign,const char *pfx,size_t pfxlen,const char *str,size_t len) {
+	size_t width = size_t(spec.width);
+	size_t n = pfxlen + len;
+
+	if ( n >= width ) {
+		out.append(pfx,pfxlen);
+		out.append(str,len);
+		return;
+	}
+
+	size_t pad = width - n;
+
+	if ( spec.zero && !spec.align ) {
+		out.append(pfx,pfxlen);
+		out.append('0',pad);
+		out.append(str,len);
+		return;
+	}
+
+	size_t left = 0, right = 0;
+
+	switch ( spec.align ? spec.align : defalign ) {
+	case '<':
+		right = pad;
+		break;
+	case '^':
+		left = pad / 2;
+		right = pad - left;
+		break;
+	default:
+		left = pad;
+	}
+	out.append(spec.fill,left);
+	out.append(pfx,pfxlen);
+	out.append(str,len);
+	out.append(spec.fill,right);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Integers, in the base selected by the spec's type
+//////////////////////////////////////////////////////////////////////
+
+static void
+emit_int(FormatBuffer& out,const FormatSpec& spec,bool neg,unsigned long long v) {
+	char pfx[4], digits[72];
+	size_t pfxlen = 0;
+	int base = 10;
+
+	if ( spec.type == 'c' ) {
+		char ch = char(v);
+
+		emit(out,spec,'<',nullptr,0,&ch,1);
+		return;
+	}
+
+	if ( neg )
+		pfx[pfxlen++] = '-';
+	else if ( spec.sign != '-' )
+		pfx[pfxlen++] = spec.sign;
+
+	switch ( spec.type ) {
+	case 'x':
+	case 'X':
+		base = 16;
+		break;
+	case 'o':
+		base = 8;
+		break;
+	case 'b':
+	case 'B':
+		base = 2;
+		break;
+	}
+
+	if ( spec.alt && base != 10 ) {
+		pfx[pfxlen++] = '0';
+		if ( base != 8 )
+			pfx[pfxlen++] = spec.type;
+	}
+
+	auto r = std::to_chars(digits,digits+sizeof digits,v,base);
+	size_t len = r.ptr - digits;
+
+	if ( spec.type == 'X' )
+		for ( size_t x=0; x<len; ++x )
+			if ( digits[x] >= 'a' )
+				digits[x] -= 'a' - 'A';
+	emit(out,spec,'>',pfx,pfxlen,digits,len);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Floating point: shortest round trip form, unless a precision or
+// presentation type is given
+//////////////////////////////////////////////////////////////////////
+
+static void
+emit_double(FormatBuffer& out,const FormatSpec& spec,double v) {
+	char pfx[2], digits[400];
+	size_t pfxlen = 0;
+	std::to_chars_result r;
+
+	if ( std::signbit(v) ) {
+		pfx[pfxlen++] = '-';
+		v = -v;
+	} else if ( spec.sign != '-' )
+		pfx[pfxlen++] = spec.sign;
+
+	char *end = digits + sizeof digits;
+	std::chars_format cf = std::chars_format::general;
+
+	switch ( spec.type ) {
+	case 'f':
+	case 'F':
+		cf = std::chars_format::fixed;
+		break;
+	case 'e':
+	case 'E':
+		cf = std::chars_format::scientific;
+		break;
+	}
+
+	if ( spec.precision >= 0 )
+		r = std::to_chars(digits,end,v,cf,spec.precision);
+	else if ( spec.type )
+		r = std::to_chars(digits,end,v,cf,6);	// As printf
+	else	r = std::to_chars(digits,end,v);
+
+	if ( r.ec != std::errc() ) {
+		emit(out,spec,'>',pfx,pfxlen,"?",1);
+		return;
+	}
+
+	size_t len = r.ptr - digits;
+
+	if ( spec.alt && !memchr(digits,'.',len) && !memchr(digits,'e',len) && len < sizeof digits && !std::isinf(v) && !std::isnan(v) )
+		digits[len++] = '.';
+	if ( spec.type == 'F' || spec.type == 'E' || spec.type == 'G' )
+		for ( size_t x=0; x<len; ++x )
+			if ( digits[x] >= 'a' && digits[x] <= 'z' )
+				digits[x] -= 'a' - 'A';
+	emit(out,spec,'>',pfx,pfxlen,digits,len);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Format one argument according to its spec
+//////////////////////////////////////////////////////////////////////
+
+static void
+emit_arg(FormatBuffer& out,const FormatSpec& spec,const FormatArg& arg) {
+	using Type = FormatArg::Type;
+
+	switch ( arg.type ) {
+	case Type::Int:
+		if ( arg.i < 0 )
+			emit_int(out,spec,true,0ull - (unsigned long long)arg.i);
+		else	emit_int(out,spec,false,arg.i);
+		break;
+	case Type::Uint:
+		emit_int(out,spec,false,arg.u);
+		break;
+	case Type::Double:
+		emit_double(out,spec,arg.d);
+		break;
+	case Type::Bool:
+		if ( spec.type && spec.type != 's' )
+			emit_int(out,spec,false,arg.b);
+		else if ( arg.b )
+			emit(out,spec,'<',nullptr,0,"true",4);
+		else	emit(out,spec,'<',nullptr,0,"false",5);
+		break;
+	case Type::Char:
+		if ( spec.type && spec.type != 'c' )
+			emit_int(out,spec,arg.c < 0,arg.c < 0 ? -(long long)arg.c : arg.c);
+		else	emit(out,spec,'<',nullptr,0,&arg.c,1);
+		break;
+	case Type::String:
+		{
+			size_t len = arg.s.len;
+
+			if ( spec.precision >= 0 && size_t(spec.precision) < len )
+				len = spec.precision;
+			emit(out,spec,'<',nullptr,0,arg.s.ptr,len);
+		}
+		break;
+	case Type::Pointer:
+		{
+			char digits[24];
+			auto r = std::to_chars(digits,digits+sizeof digits,uintptr_t(arg.p),16);
+
+			emit(out,spec,'>',"0x",2,digits,r.ptr-digits);
+		}
+		break;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Format into out. The format string has already been checked
+// against the arguments (by FormatString at compile time).
+//////////////////////////////////////////////////////////////////////
+
+void
+format_to(FormatBuffer& out,std::string_view fmt,const FormatArg *args,size_t nargs) {
+	const char *cp = fmt.data();
+	size_t len = fmt.size(), next = 0, x = 0;
+
+	while ( x < len ) {
+		const char *ep = (const char *)memchr(cp+x,'{',len-x);
+		const char *rp = (const char *)memchr(cp+x,'}',(ep ? ep - cp : len) - x);
+
+		if ( rp ) {				// "}}"
+			out.append(cp+x,rp-cp-x+1);
+			x = rp - cp + 2;
+			continue;
+		}
+		if ( !ep ) {
+			out.append(cp+x,len-x);
+			break;
+		}
+		out.append(cp+x,ep-cp-x);
+		x = ep - cp + 1;
+		if ( x < len && cp[x] == '{' ) {	// "{{"
+			out.append('{');
+			++x;
+			continue;
+		}
+
+		FormatSpec spec;
+
+		x = spec.parse(fmt,x);
+
+		size_t argx = spec.arg >= 0 ? size_t(spec.arg) : next++;
+
+		assert(argx < nargs);
+		emit_arg(out,spec,args[argx]);
+	}
+}
+
+// End format.cpp
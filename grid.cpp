@@ -0,0 +1,333 @@
+//////////////////////////////////////////////////////////////////////
+// grid.cpp -- C++ NCurses Class Library -- Virtual table widget
+// Date: Sun Oct 18 04:10:51 2026   (C) ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <limits.h>
+
+#include <cppcurses/grid.hpp>
+#include <cppcurses/trace.hpp>
+
+static constexpr uint64_t title_row = ~uint64_t(0);	// row_at(): the titles
+
+Grid::Grid(Window *parent,short y,short x,short nlines,short ncols,std::vector<Column> columns,
+  Source source,void *arg,bool border)
+: columns(std::move(columns)), source(source), arg(arg) {
+
+	assert(source);
+	w = border ? parent->border_window(y,x,nlines,ncols) : parent->new_window(y,x,nlines,ncols);
+	autosize();
+}
+
+Grid::~Grid() {
+	delete w;
+}
+
+int
+Grid::title_rows() const {
+
+	for ( auto& col : columns )
+		if ( !col.title.empty() )
+			return 1;
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Number of screen rows for the scrolling rows
+//////////////////////////////////////////////////////////////////////
+
+int
+Grid::body_rows() {
+	int wrows, wcols, fixed;
+
+	w->sub_size(wrows,wcols);
+	fixed = title_rows() + int(frozen);
+	return wrows > fixed ? wrows - fixed : 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// The source row shown in screen row r (as of shown_top), title_row
+// for the titles. The result may be past the last row.
+//////////////////////////////////////////////////////////////////////
+
+uint64_t
+Grid::row_at(int r) const {
+	int t = title_rows();
+
+	if ( r < t )
+		return title_row;
+	if ( uint64_t(r - t) < frozen )
+		return uint64_t(r - t);
+	return shown_top + uint64_t(r - t);
+}
+
+Grid&
+Grid::rows(uint64_t n) {
+	uint64_t from = n < nrows ? n : nrows;	// Rows that appeared or vanished
+
+	nrows = n;
+	for ( size_t r=0; r<dirty.size(); ++r ) {
+		uint64_t row = row_at(int(r));
+
+		if ( row != title_row && row >= from )
+			dirty[r] = true;
+	}
+	return *this;
+}
+
+Grid&
+Grid::freeze(uint64_t n) {
+
+	frozen = n;
+	redrawf = true;
+	return *this;
+}
+
+Grid&
+Grid::title_style(const Style& style) {
+
+	titles = style;
+	if ( title_rows() && !dirty.empty() )
+		dirty[0] = true;
+	return *this;
+}
+
+Grid&
+Grid::invalidate(uint64_t row) {
+
+	for ( size_t r=0; r<dirty.size(); ++r )
+		if ( row_at(int(r)) == row ) {
+			dirty[r] = true;
+			break;
+		}
+	return *this;
+}
+
+Grid&
+Grid::invalidate() {
+
+	dirty.assign(dirty.size(),true);
+	return *this;
+}
+
+Grid&
+Grid::autosize() {
+
+	widths.resize(columns.size());
+	for ( size_t c=0; c<columns.size(); ++c ) {
+		int width = columns[c].width;
+
+		if ( width <= 0 ) {
+			Window::clip_text(columns[c].title,SHRT_MAX,width);
+			if ( width < 1 )
+				width = 1;
+		}
+		widths[c] = short(width);
+	}
+	redrawf = true;
+	return *this;
+}
+
+Grid&
+Grid::scroll_to(uint64_t row) {
+
+	top = row > frozen ? row - frozen : 0;
+	return *this;
+}
+
+Grid&
+Grid::scroll_up(uint64_t n) {
+
+	top = n > top ? 0 : top - n;
+	return *this;
+}
+
+Grid&
+Grid::scroll_down(uint64_t n) {
+	uint64_t body = body_rows();
+	uint64_t scrollable = nrows > frozen ? nrows - frozen : 0;
+	uint64_t max_top = scrollable > body ? scrollable - body : 0;
+
+	top = n > max_top - top || top > max_top ? max_top : top + n;
+	return *this;
+}
+
+Grid&
+Grid::page_up() {
+	return scroll_up(body_rows());
+}
+
+Grid&
+Grid::page_down() {
+	return scroll_down(body_rows());
+}
+
+//////////////////////////////////////////////////////////////////////
+// Fetch the cells of a row into screen row r's texts. Columns of
+// width 0 are widened to fit (up to the window width).
+//////////////////////////////////////////////////////////////////////
+
+void
+Grid::fetch(int r,uint64_t row,bool& grown) {
+	int wrows, wcols;
+
+	w->sub_size(wrows,wcols);
+	for ( size_t c=0; c<columns.size(); ++c ) {
+		std::string& text = texts[size_t(r) * columns.size() + c];
+
+		cell.text.clear();
+		cell.style = Style();
+		source(arg,row,unsigned(c),cell);
+		text.assign(cell.text.data(),cell.text.size());
+		styles[size_t(r) * columns.size() + c] = cell.style;
+		++statistics.cells;
+
+		if ( columns[c].width <= 0 ) {
+			int width;
+
+			Window::clip_text(text,wcols,width);
+			if ( width > widths[c] ) {
+				widths[c] = short(width);
+				grown = true;
+			}
+		}
+	}
+}
+
+static void
+pad(Window *w,int n) {
+	static const char spaces[] = "                                                                ";
+
+	while ( n > 0 ) {
+		int k = n < int(sizeof spaces - 1) ? n : int(sizeof spaces - 1);
+
+		w->addstr(std::string_view(spaces,k));
+		n -= k;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Draw screen row r: the cells are clipped or padded to the column
+// widths, with one column of space between columns
+//////////////////////////////////////////////////////////////////////
+
+void
+Grid::draw(int r,uint64_t row,int cols) {
+	int x = 0;
+
+	w->move(r,0);
+	if ( row == title_row || row < nrows ) {
+		for ( size_t c=0; c<columns.size() && x<cols; ++c ) {
+			int cw = widths[c] < cols - x ? widths[c] : cols - x;
+			std::string_view text = row == title_row ? columns[c].title : texts[size_t(r) * columns.size() + c];
+			int width;
+			size_t len = Window::clip_text(text,cw,width);
+
+			w->style(row == title_row ? titles : styles[size_t(r) * columns.size() + c]);
+			if ( columns[c].right )
+				pad(w,cw - width);
+			w->addstr(text.substr(0,len));
+			if ( !columns[c].right )
+				pad(w,cw - width);
+			x += cw;
+			if ( x < cols ) {
+				w->style(Style());
+				pad(w,1);
+				++x;
+			}
+		}
+	}
+	if ( x < cols ) {
+		w->style(Style());
+		w->clrtoeol();
+	}
+	++statistics.rows_drawn;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Bring the window up to date. Only invalidated rows and rows that
+// came into view are fetched and drawn. The screen is updated by the
+// refresh.
+//////////////////////////////////////////////////////////////////////
+
+Grid&
+Grid::render() {
+	CPPCURSES_SPAN("Grid::render");
+	int wrows, wcols;
+
+	w->sub_size(wrows,wcols);
+	if ( wrows <= 0 || wcols <= 0 )
+		return *this;
+
+	int t = title_rows();
+	int fixed = t + int(frozen < uint64_t(wrows) ? frozen : wrows);
+	int body = wrows > fixed ? wrows - fixed : 0;
+	uint64_t scrollable = nrows > frozen ? nrows - frozen : 0;
+	uint64_t max_top = scrollable > uint64_t(body) ? scrollable - body : 0;
+
+	if ( top > max_top )
+		top = max_top;
+
+	if ( wrows != shown_rows || wcols != shown_cols ) {
+		dirty.assign(wrows,true);
+		texts.resize(size_t(wrows) * columns.size());
+		styles.resize(size_t(wrows) * columns.size());
+		shown_rows = wrows;
+		shown_cols = wcols;
+		redrawf = true;
+	}
+
+	int64_t delta = int64_t(top - shown_top);
+
+	if ( !redrawf && delta != 0 ) {
+		if ( delta > -body && delta < body ) {
+			w->scroll(int(delta),short(fixed),short(wrows-1));
+			if ( delta > 0 ) {
+				for ( int r=fixed; r<wrows; ++r )
+					dirty[r] = r + delta < wrows ? bool(dirty[r + delta]) : true;
+			} else	{
+				for ( int r=wrows-1; r>=fixed; --r )
+					dirty[r] = r + delta >= fixed ? bool(dirty[r + delta]) : true;
+			}
+			++statistics.scrolls;
+		} else	redrawf = true;
+	}
+	if ( redrawf ) {
+		w->erase();
+		dirty.assign(wrows,true);
+		++statistics.redraws;
+	}
+	shown_top = top;
+
+	bool grown = false;
+
+	for ( int r=t; r<wrows; ++r ) {
+		uint64_t row = row_at(r);
+
+		if ( dirty[r] && row < nrows )
+			fetch(r,row,grown);
+	}
+	if ( grown ) {				// Every row must be laid out again
+		for ( int r=0; r<wrows; ++r ) {
+			uint64_t row = row_at(r);
+
+			if ( !dirty[r] && row != title_row && row < nrows )
+				fetch(r,row,grown);
+			dirty[r] = true;
+		}
+	}
+
+	for ( int r=0; r<wrows; ++r )
+		if ( dirty[r] ) {
+			draw(r,row_at(r),wcols);
+			dirty[r] = false;
+		}
+
+	redrawf = false;
+	return *this;
+}
+
+// End grid.cpp
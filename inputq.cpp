@@ -0,0 +1,465 @@
+//////////////////////////////////////////////////////////////////////
+// inputq.cpp -- C++ NCurses Class Library -- Input event queue
+// Date: Sun Oct 18 04:02:18 2026   (C) ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <assert.h>
+#include <limits.h>
+#include <wchar.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include <cppcurses/inputq.hpp>
+
+#include <curses.h>
+
+static constexpr size_t more = 0;		// decode_key(): incomplete
+static constexpr size_t none = size_t(-1);	// decode_key(): no match
+
+//////////////////////////////////////////////////////////////////////
+// Cursor key sequences of both xterm modes, in case terminfo only
+// lists one of them
+//////////////////////////////////////////////////////////////////////
+
+static const std::pair<const char *,Key> xterm_keys[] = {
+	{ "\033[A", Key::Up },		{ "\033OA", Key::Up },
+	{ "\033[B", Key::Down },	{ "\033OB", Key::Down },
+	{ "\033[C", Key::Right },	{ "\033OC", Key::Right },
+	{ "\033[D", Key::Left },	{ "\033OD", Key::Left },
+	{ "\033[H", Key::Home },	{ "\033OH", Key::Home },
+	{ "\033[F", Key::End },		{ "\033OF", Key::End },
+};
+
+static long
+futex(std::atomic<uint32_t>& word,int op,uint32_t val,const timespec *timeout) {
+	return syscall(SYS_futex,(uint32_t*)&word,op,val,timeout,nullptr,0);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Start the input thread. This must be called on the curses thread.
+//////////////////////////////////////////////////////////////////////
+
+InputQueue::InputQueue(CppCurses& curses,unsigned capacity,bool mouse)
+: curses(curses), ttyfd(curses.ttyfd), sigfd(curses.sigfd), mousef(mouse) {
+	uint32_t n = 2;
+
+	assert(curses.openf);
+	while ( n < capacity )
+		n <<= 1;
+	slots.reset(new Slot[n]);
+	mask = n - 1;
+	for ( uint32_t x=0; x<n; ++x )
+		slots[x].seq.store(x,std::memory_order_relaxed);
+
+	for ( auto& b : Window::key_bindings() )
+		if ( b.second != Key::Mouse )		// kmous: reports are decoded below
+			bindings.push_back(b);
+	for ( auto& xk : xterm_keys ) {
+		bool found = false;
+
+		for ( auto& b : bindings )
+			if ( b.first == xk.first )
+				found = true;
+		if ( !found )
+			bindings.emplace_back(xk.first,xk.second);
+	}
+
+	escdelay = get_escdelay();
+	++curses.inputqs;			// The thread takes the typeahead
+	curses.check_typeahead();
+	if ( mousef )
+		mousemask(ALL_MOUSE_EVENTS,nullptr);	// Curses sends the enabling sequence
+
+	stopfd = eventfd(0,EFD_CLOEXEC);
+	thread = std::thread(&InputQueue::run,this);
+}
+
+InputQueue::~InputQueue() {
+	uint64_t one = 1;
+
+	stopf = true;
+	if ( write(stopfd,&one,sizeof one) != sizeof one )
+		assert(0);
+	thread.join();
+	wake();					// Release blocked consumers
+	while ( waiters.load() > 0 ) {		// .. and wait for them to leave
+		std::this_thread::yield();
+		wake();
+	}
+	::close(stopfd);
+	if ( mousef )
+		mousemask(0,nullptr);
+	if ( --curses.inputqs == 0 && curses.openf )
+		curses.check_typeahead();
+}
+
+//////////////////////////////////////////////////////////////////////
+// The input thread: wait for terminal input, SIGWINCH or stop. After
+// an incomplete sequence (such as a lone ESC), wait at most escdelay
+// ms for the rest of it.
+//////////////////////////////////////////////////////////////////////
+
+void
+InputQueue::run() {
+	int epfd = epoll_create1(EPOLL_CLOEXEC);
+	epoll_event ev;
+	std::string pending;
+	char buf[256];
+
+	for ( int fd : { ttyfd, sigfd, stopfd } ) {
+		if ( fd < 0 )
+			continue;
+		memset(&ev,0,sizeof ev);
+		ev.events = EPOLLIN;
+		ev.data.fd = fd;
+		epoll_ctl(epfd,EPOLL_CTL_ADD,fd,&ev);
+	}
+
+	for (;;) {
+		epoll_event evs[3];
+		int n = epoll_wait(epfd,evs,3,pending.empty() ? -1 : escdelay);
+
+		if ( n < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			break;
+		}
+		if ( n == 0 ) {				// The rest did not arrive
+			pending.erase(0,decode(pending.data(),pending.size(),true));
+			continue;
+		}
+		for ( int x=0; x<n; ++x ) {
+			int fd = evs[x].data.fd;
+
+			if ( fd == stopfd ) {
+				::close(epfd);
+				return;
+			} else if ( fd == sigfd ) {
+				signalfd_siginfo si;
+				winsize ws;
+				InputEvent rev;
+
+				while ( read(sigfd,&si,sizeof si) == sizeof si )
+					;		// Coalesce pending SIGWINCHes
+				if ( ioctl(ttyfd,TIOCGWINSZ,&ws) == 0 && ws.ws_row > 0 && ws.ws_col > 0 ) {
+					rev.type = InputEvent::Type::Resize;
+					rev.key = Key::Resize;
+					rev.y = ws.ws_row;
+					rev.x = ws.ws_col;
+					push(rev);
+				}
+			} else	{
+				ssize_t rc = read(ttyfd,buf,sizeof buf);
+
+				if ( rc > 0 )
+					pending.append(buf,rc);
+				else if ( rc == 0 || (errno != EINTR && errno != EAGAIN) )
+					epoll_ctl(epfd,EPOLL_CTL_DEL,ttyfd,nullptr);
+			}
+		}
+		pending.erase(0,decode(pending.data(),pending.size(),false));
+	}
+	::close(epfd);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Decode a character: ASCII, or multibyte per the locale. Returns
+// the bytes used, or 0 if incomplete (and not final).
+//////////////////////////////////////////////////////////////////////
+
+static size_t
+decode_char(const char *buf,size_t n,bool final,uint32_t& ch) {
+	mbstate_t mbs{};
+	wchar_t wc;
+	size_t rc;
+
+	if ( uint8_t(*buf) < 0x80 ) {
+		ch = uint8_t(*buf);
+		return 1;
+	}
+	rc = mbrtowc(&wc,buf,n,&mbs);
+	if ( rc == size_t(-2) && !final )
+		return 0;
+	if ( rc == size_t(-1) || rc == size_t(-2) || rc == 0 ) {
+		ch = 0xFFFD;
+		return 1;
+	}
+	ch = uint32_t(wc);
+	return rc;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Mouse button byte (xterm encoding) to an event
+//////////////////////////////////////////////////////////////////////
+
+static void
+mouse_event(InputEvent& ev,int b,int x,int y,bool release) {
+
+	ev.type = InputEvent::Type::Mouse;
+	ev.key = Key::Mouse;
+	ev.x = short(x);
+	ev.y = short(y);
+	ev.mods = (b & 4 ? InputEvent::Shift : 0) | (b & 8 ? InputEvent::Alt : 0) | (b & 16 ? InputEvent::Ctrl : 0);
+	ev.button = (b & 3) == 3 ? 0 : (b & 3) + 1;
+	if ( b & 64 ) {
+		ev.button = 4 + (b & 1);		// Wheel
+		ev.action = InputEvent::Action::Press;
+	} else if ( b & 32 )
+		ev.action = InputEvent::Action::Motion;
+	else	ev.action = release || !ev.button ? InputEvent::Action::Release : InputEvent::Action::Press;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Decode an escape sequence: a key from the terminal's bindings, a
+// mouse report or an xterm modified cursor key. Returns the bytes
+// used (with valid false, if they were not understood), more if the
+// sequence is incomplete, or none if buf does not start with one.
+//////////////////////////////////////////////////////////////////////
+
+size_t
+InputQueue::decode_key(const char *buf,size_t n,bool final,InputEvent& ev,bool& valid) {
+	size_t best = 0;
+	bool longer = false;
+	Key key = Key::Event;
+
+	valid = true;
+	for ( auto& b : bindings ) {
+		const std::string& seq = b.first;
+
+		if ( seq.size() <= n ) {
+			if ( seq.size() > best && !memcmp(seq.data(),buf,seq.size()) ) {
+				best = seq.size();
+				key = b.second;
+			}
+		} else if ( !memcmp(seq.data(),buf,n) )
+			longer = true;
+	}
+	if ( longer && !final )
+		return more;
+	if ( best > 0 ) {
+		ev.type = InputEvent::Type::Key;
+		ev.key = key;
+		return best;
+	}
+
+	if ( n < 2 || buf[0] != '\033' || buf[1] != '[' )
+		return n < 2 && buf[0] == '\033' && !final ? more : none;
+
+	if ( n >= 3 && buf[2] == 'M' ) {		// X10 mouse: ESC [ M b x y
+		if ( n < 6 )
+			return final ? none : more;
+		mouse_event(ev,uint8_t(buf[3]) - 32,uint8_t(buf[4]) - 33,uint8_t(buf[5]) - 33,(uint8_t(buf[3]) & 3) == 3);
+		return 6;
+	}
+
+	// CSI [<] params final
+	bool sgr = n >= 3 && buf[2] == '<';
+	int params[4] = { 0, 0, 0, 0 };
+	unsigned np = 0;
+
+	for ( size_t x = sgr ? 3 : 2; x < n && x < 32; ++x ) {
+		uint8_t ch = buf[x];
+
+		if ( ch >= '0' && ch <= '9' ) {
+			if ( np < 4 )
+				params[np] = params[np] * 10 + (ch - '0');
+		} else if ( ch == ';' )
+			++np;
+		else if ( ch >= 0x40 && ch <= 0x7E ) {
+			++np;
+			if ( sgr && (ch == 'M' || ch == 'm') && np == 3 ) {
+				mouse_event(ev,params[0],params[1] - 1,params[2] - 1,ch == 'm');
+				return x + 1;
+			}
+			if ( !sgr && np == 2 && params[0] == 1 && strchr("ABCDHF",ch) ) {
+				static const Key keys[] = { Key::Up, Key::Down, Key::Right, Key::Left, Key::Home, Key::End };
+				int m = params[1] - 1;
+
+				ev.type = InputEvent::Type::Key;
+				ev.key = keys[strchr("ABCDHF",ch) - "ABCDHF"];
+				ev.mods = (m & 1 ? InputEvent::Shift : 0) | (m & 2 ? InputEvent::Alt : 0) | (m & 4 ? InputEvent::Ctrl : 0);
+				return x + 1;
+			}
+			valid = false;			// Unknown: discard it
+			return x + 1;
+		} else if ( ch < 0x20 || ch > 0x3F ) {
+			valid = false;
+			return x;
+		}
+	}
+	if ( n >= 32 || final ) {
+		valid = false;
+		return n < 32 ? n : 32;
+	}
+	return more;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Decode and publish events from buf, returning the bytes used. If
+// final, incomplete sequences are taken as they are.
+//////////////////////////////////////////////////////////////////////
+
+size_t
+InputQueue::decode(const char *buf,size_t n,bool final) {
+	size_t x = 0;
+
+	while ( x < n ) {
+		InputEvent ev;
+		bool valid = true;
+		size_t used = decode_key(buf+x,n-x,final,ev,valid);
+
+		if ( used == more )
+			break;
+		if ( used == none ) {
+			uint32_t ch;
+
+			if ( buf[x] == '\033' && x + 1 < n ) {	// ESC char is Alt+char
+				if ( (used = decode_char(buf+x+1,n-x-1,final,ch)) == 0 )
+					break;
+				++used;
+				ev.mods = InputEvent::Alt;
+			} else if ( (used = decode_char(buf+x,n-x,final,ch)) == 0 )
+				break;
+			ev.type = InputEvent::Type::Char;
+			ev.ch = ch;
+		}
+		if ( valid )
+			push(ev);
+		x += used;
+	}
+	return x;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Publish an event (the ring is a bounded MPMC queue, after Dmitry
+// Vyukov's). When full, the event is dropped.
+//////////////////////////////////////////////////////////////////////
+
+bool
+InputQueue::push(const InputEvent& ev) {
+	uint32_t pos = enqueue_pos.load(std::memory_order_relaxed);
+
+	for (;;) {
+		Slot& slot = slots[pos & mask];
+		int32_t diff = int32_t(slot.seq.load(std::memory_order_acquire) - pos);
+
+		if ( diff == 0 ) {
+			if ( enqueue_pos.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed) ) {
+				slot.ev = ev;
+				slot.seq.store(pos+1,std::memory_order_release);
+				break;
+			}
+		} else if ( diff < 0 ) {
+			dropped.fetch_add(1,std::memory_order_relaxed);
+			return false;
+		} else	pos = enqueue_pos.load(std::memory_order_relaxed);
+	}
+	events.fetch_add(1,std::memory_order_relaxed);
+	wake();
+	return true;
+}
+
+void
+InputQueue::wake() {
+
+	seq.fetch_add(1);
+	if ( waiters.load() > 0 )
+		futex(seq,FUTEX_WAKE_PRIVATE,INT_MAX,nullptr);
+}
+
+bool
+InputQueue::try_pop(InputEvent& ev) {
+	uint32_t pos = dequeue_pos.load(std::memory_order_relaxed);
+
+	for (;;) {
+		Slot& slot = slots[pos & mask];
+		int32_t diff = int32_t(slot.seq.load(std::memory_order_acquire) - (pos + 1));
+
+		if ( diff == 0 ) {
+			if ( dequeue_pos.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed) ) {
+				ev = slot.ev;
+				slot.seq.store(pos+mask+1,std::memory_order_release);
+				return true;
+			}
+		} else if ( diff < 0 )
+			return false;			// Empty
+		else	pos = dequeue_pos.load(std::memory_order_relaxed);
+	}
+}
+
+bool
+InputQueue::pop(InputEvent& ev) {
+	return pop(ev,-1);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Pop an event, waiting up to ms milliseconds (ms < 0 waits until
+// an event arrives or the queue is destroyed). A waiting consumer is
+// counted in waiters until its last use of the queue, so that the
+// destructor can wait for it to return.
+//////////////////////////////////////////////////////////////////////
+
+bool
+InputQueue::pop(InputEvent& ev,int ms) {
+	timespec deadline, now, rel;
+
+	if ( try_pop(ev) )
+		return true;
+	if ( ms == 0 )
+		return false;
+	if ( ms > 0 ) {
+		clock_gettime(CLOCK_MONOTONIC,&deadline);
+		deadline.tv_sec += ms / 1000;
+		deadline.tv_nsec += long(ms % 1000) * 1000000L;
+		if ( deadline.tv_nsec >= 1000000000L ) {
+			++deadline.tv_sec;
+			deadline.tv_nsec -= 1000000000L;
+		}
+	}
+
+	bool got = false;
+
+	waiters.fetch_add(1);			// The destructor waits for us
+	for (;;) {
+		uint32_t s = seq.load();
+
+		if ( (got = try_pop(ev)) || stopf )
+			break;
+		if ( ms > 0 ) {
+			clock_gettime(CLOCK_MONOTONIC,&now);
+			rel.tv_sec = deadline.tv_sec - now.tv_sec;
+			rel.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+			if ( rel.tv_nsec < 0 ) {
+				--rel.tv_sec;
+				rel.tv_nsec += 1000000000L;
+			}
+			if ( rel.tv_sec < 0 ) {
+				got = try_pop(ev);
+				break;		// Timed out
+			}
+		}
+		futex(seq,FUTEX_WAIT_PRIVATE,s,ms > 0 ? &rel : nullptr);
+	}
+	waiters.fetch_sub(1);			// Last use of the queue
+	return got;
+}
+
+InputQueue::Stats
+InputQueue::stats() const {
+	Stats st;
+
+	st.events = events.load(std::memory_order_relaxed);
+	st.dropped = dropped.load(std::memory_order_relaxed);
+	return st;
+}
+
+// End inputq.cpp
@@ -0,0 +1,268 @@
+//////////////////////////////////////////////////////////////////////
+// layout.cpp -- C++ NCurses Class Library -- Split layouts
+// Date: Sun Oct 18 04:48:32 2026   (C) ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <assert.h>
+
+#include <algorithm>
+
+#include <cppcurses/layout.hpp>
+#include <cppcurses/trace.hpp>
+
+Layout::Layout(Split split) {
+
+	items.emplace_back();
+	items[0].split = split;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Mark the path from the root down to node n, so that apply()
+// descends to it (stopping where the path is already marked)
+//////////////////////////////////////////////////////////////////////
+
+void
+Layout::mark(Node n) {
+
+	for ( Node p = items[n].parent; p != none && !items[p].belowf; p = items[p].parent )
+		items[p].belowf = true;
+}
+
+Layout::Node
+Layout::add(Node parent,Size size,Split split) {
+	Node n = Node(items.size());
+
+	assert(parent < n);
+	items.emplace_back();
+
+	Item& item = items[n];
+	Item& p = items[parent];
+
+	item.size = size;
+	item.split = split;
+	item.parent = parent;
+	if ( p.last == none )
+		p.first = n;
+	else	items[p.last].next = n;
+	p.last = n;
+	p.sizedf = true;
+	mark(parent);
+	return n;
+}
+
+Layout&
+Layout::size(Node n,Size size) {
+	Item& item = items[n];
+
+	item.size = size;
+	if ( item.parent != none ) {
+		items[item.parent].sizedf = true;	// The siblings share anew
+		mark(item.parent);
+	}
+	return *this;
+}
+
+Layout&
+Layout::split(Node n,Split split) {
+
+	items[n].split = split;
+	items[n].sizedf = true;
+	mark(n);
+	return *this;
+}
+
+Layout&
+Layout::pad(Node n,short cells) {
+
+	items[n].pad = cells;
+	items[n].sizedf = true;
+	mark(n);
+	return *this;
+}
+
+Layout&
+Layout::attach(Node n,Window *w) {
+	Item& item = items[n];
+
+	if ( item.w && item.hidf )
+		item.w->unhide();
+	item.w = w;
+	item.hidf = false;
+	item.placef = w != nullptr;
+	mark(n);
+	return *this;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Size the children along the split: the fixed children first, then
+// the others share the space left by weight. A share outside of its
+// child's limits is fixed at the limit, and the rest shared again.
+// Shares are rounded by their running total, so that they add up.
+//////////////////////////////////////////////////////////////////////
+
+void
+Layout::distribute(Item& item,int space) {
+	int left = space;
+	uint64_t weights = 0;
+	bool againf = true;
+
+	for ( Node c = item.first; c != none; c = items[c].next ) {
+		Item& child = items[c];
+
+		if ( child.size.cells > 0 ) {
+			child.extent = std::min(std::max(child.size.cells,child.size.min),child.size.max);
+			left -= child.extent;
+		} else	{
+			child.extent = -1;		// Takes a share
+			weights += child.size.weight;
+		}
+	}
+
+	while ( againf && weights > 0 ) {
+		uint64_t shared = std::max(left,0);
+
+		againf = false;
+		for ( Node c = item.first; c != none; c = items[c].next ) {
+			Item& child = items[c];
+
+			if ( child.extent >= 0 )
+				continue;
+
+			int64_t share = int64_t(shared * child.size.weight / weights);
+
+			if ( share < child.size.min )
+				child.extent = child.size.min;
+			else if ( share > child.size.max )
+				child.extent = child.size.max;
+			else	continue;
+			left -= child.extent;
+			weights -= child.size.weight;
+			againf = true;
+		}
+	}
+
+	uint64_t shared = std::max(left,0), sum = 0;
+	int given = 0;
+
+	for ( Node c = item.first; c != none; c = items[c].next ) {
+		Item& child = items[c];
+
+		if ( child.extent >= 0 )
+			continue;
+		if ( weights > 0 ) {
+			int upto;
+
+			sum += child.size.weight;
+			upto = int(shared * sum / weights);
+			child.extent = short(upto - given);
+			given = upto;
+		} else	child.extent = 0;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Give node n the rectangle r. A node whose rectangle is unchanged,
+// with nothing marked within it, is left alone with its subtree.
+//////////////////////////////////////////////////////////////////////
+
+void
+Layout::layout(Node n,const Rect& r) {
+	Item& item = items[n];
+	bool movedf = !(r == item.rect);
+
+	if ( !movedf && !item.sizedf && !item.belowf && !item.placef )
+		return;
+	++statistics.visits;
+	item.rect = r;
+	if ( item.w && (movedf || item.placef) )
+		place(item);
+
+	if ( item.first != none ) {
+		bool rowsf = item.split == Split::Rows;
+		Rect inner;
+
+		inner.y = r.y + item.pad;
+		inner.x = r.x + item.pad;
+		inner.nlines = short(std::max(r.nlines - 2 * item.pad,0));
+		inner.ncols = short(std::max(r.ncols - 2 * item.pad,0));
+
+		int space = rowsf ? inner.nlines : inner.ncols;
+		int pos = 0;
+
+		if ( movedf || item.sizedf ) {
+			distribute(item,space);
+			++statistics.sized;
+		}
+		for ( Node c = item.first; c != none; c = items[c].next ) {
+			Rect cr = inner;
+			int extent = std::clamp(int(items[c].extent),0,space - pos);
+
+			if ( rowsf ) {
+				cr.y = short(inner.y + pos);
+				cr.nlines = short(extent);
+			} else	{
+				cr.x = short(inner.x + pos);
+				cr.ncols = short(extent);
+			}
+			pos += extent;
+			layout(c,cr);
+		}
+	}
+	item.sizedf = item.belowf = item.placef = false;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Move and resize the node's window to its rectangle, or hide it
+// while the rectangle is empty (it comes back at its place in the
+// stack, under any popups raised meanwhile)
+//////////////////////////////////////////////////////////////////////
+
+void
+Layout::place(Item& item) {
+	const Rect& r = item.rect;
+
+	if ( r.nlines <= 0 || r.ncols <= 0 ) {
+		if ( !item.hidf ) {
+			item.w->hide();
+			item.hidf = true;
+		}
+		return;
+	}
+	item.w->place(r.y,r.x,r.nlines,r.ncols);
+	if ( item.hidf ) {
+		item.w->unhide();
+		item.hidf = false;
+	}
+	++statistics.placed;
+}
+
+bool
+Layout::apply(const Rect& r) {
+	CPPCURSES_SPAN("Layout::apply");
+	uint64_t placed = statistics.placed;
+
+	++statistics.passes;
+	layout(0,r);
+	return statistics.placed != placed;
+}
+
+bool
+Layout::apply(short rows,short cols) {
+	Rect r;
+
+	r.nlines = rows;
+	r.ncols = cols;
+	return apply(r);
+}
+
+//////////////////////////////////////////////////////////////////////
+// An on_resize() function (arg is the Layout), for the main window:
+// the layout follows the terminal size
+//////////////////////////////////////////////////////////////////////
+
+void
+Layout::resized(void *arg,Window&,short rows,short cols) {
+	((Layout*)arg)->apply(rows,cols);
+}
+
+// End layout.cpp
@@ -0,0 +1,223 @@
+//////////////////////////////////////////////////////////////////////
+// logwin.cpp -- C++ NCurses Class Library -- Scrolling log window
+// Date: Sun Oct 18 04:07:56 2026   (C) ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include <cppcurses/logwin.hpp>
+#include <cppcurses/trace.hpp>
+
+LogWindow::LogWindow(Window *parent,short y,short x,short nlines,short ncols,size_t max_lines,size_t arena_bytes,bool border) {
+	uint64_t n = 2;
+
+	assert(max_lines > 0 && arena_bytes > 0);
+	while ( n < max_lines )
+		n <<= 1;
+	lines.reset(new Line[n]);
+	line_mask = n - 1;
+	arena.reset(new char[arena_bytes]);
+	arena_size = arena_bytes;
+
+	w = border ? parent->border_window(y,x,nlines,ncols) : parent->new_window(y,x,nlines,ncols);
+}
+
+LogWindow::~LogWindow() {
+	delete w;
+}
+
+uint64_t
+LogWindow::rows() {
+	int nrows, ncols;
+
+	w->sub_size(nrows,ncols);
+	return nrows > 0 ? uint64_t(nrows) : 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Append text, one line per '\n' (a final '\n' is optional)
+//////////////////////////////////////////////////////////////////////
+
+LogWindow&
+LogWindow::append(std::string_view text) {
+
+	if ( !text.empty() && text.back() == '\n' )
+		text.remove_suffix(1);
+
+	for (;;) {
+		size_t nl = text.find('\n');
+
+		if ( nl == std::string_view::npos )
+			break;
+		add_line(text.data(),nl);
+		text.remove_prefix(nl + 1);
+	}
+	add_line(text.data(),text.size());
+	return *this;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Store a line. Its text never wraps around the end of the arena, and
+// the oldest lines are dropped when the arena or the ring is full.
+//////////////////////////////////////////////////////////////////////
+
+void
+LogWindow::add_line(const char *text,size_t len) {
+	uint64_t off, end;
+	char *dst;
+
+	if ( len > max_line )
+		len = max_line;
+	if ( len > arena_size )
+		len = arena_size;
+
+	off = wpos % arena_size;
+	if ( off + len > arena_size )
+		wpos += arena_size - off;	// Skip to the start of the arena
+	end = wpos + len;
+
+	while ( first < next && (next - first > line_mask || lines[first & line_mask].pos + arena_size < end) ) {
+		++first;
+		++statistics.evicted;
+	}
+
+	dst = arena.get() + wpos % arena_size;
+	for ( size_t x=0; x<len; ++x ) {
+		uint8_t ch = text[x];
+
+		dst[x] = ch < 0x20 || ch == 0x7F ? ' ' : char(ch);
+	}
+
+	Line& ln = lines[next & line_mask];
+
+	ln.pos = wpos;
+	ln.len = uint32_t(len);
+	ln.attrs = cur_style.attrs.bits;
+	ln.pair = cur_style.pair;
+
+	wpos = end;
+	++next;
+	++statistics.appended;
+	if ( back > 0 )
+		++back;				// Keep the scrolled back view still
+}
+
+bool
+LogWindow::line(uint64_t n,std::string_view& text) const {
+
+	if ( n >= next - first )
+		return false;
+
+	const Line& ln = lines[(first + n) & line_mask];
+
+	text = std::string_view(arena.get() + ln.pos % arena_size,ln.len);
+	return true;
+}
+
+LogWindow&
+LogWindow::scroll_up(uint64_t n) {
+	uint64_t nrows = rows(), count = next - first;
+	uint64_t max_back = count > nrows ? count - nrows : 0;
+
+	back = n > max_back - back || back > max_back ? max_back : back + n;
+	return *this;
+}
+
+LogWindow&
+LogWindow::scroll_down(uint64_t n) {
+
+	back = n > back ? 0 : back - n;
+	return *this;
+}
+
+LogWindow&
+LogWindow::page_up() {
+	return scroll_up(rows());
+}
+
+LogWindow&
+LogWindow::page_down() {
+	return scroll_down(rows());
+}
+
+LogWindow&
+LogWindow::scroll_to_end() {
+
+	back = 0;
+	return *this;
+}
+
+void
+LogWindow::draw_line(short row,uint64_t seq,int cols) {
+	const Line& ln = lines[seq & line_mask];
+	const char *text = arena.get() + ln.pos % arena_size;
+	int width;
+	size_t len = Window::clip_text(std::string_view(text,ln.len),cols,width);
+
+	w->move(row,0).attr_set(Attrs(ln.attrs),ln.pair).addstr(std::string_view(text,len));
+	if ( width < cols )
+		w->clrtoeol();
+	++statistics.lines_drawn;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Bring the window up to date with the view. When the view moved by
+// less than a window height, the window is scrolled and only the
+// exposed lines are drawn. The screen is updated by the refresh.
+//////////////////////////////////////////////////////////////////////
+
+LogWindow&
+LogWindow::render() {
+	CPPCURSES_SPAN("LogWindow::render");
+	int nrows, ncols;
+
+	w->sub_size(nrows,ncols);
+	if ( nrows <= 0 || ncols <= 0 )
+		return *this;
+
+	uint64_t count = next - first;
+	uint64_t max_back = count > uint64_t(nrows) ? count - nrows : 0;
+
+	if ( back > max_back )
+		back = max_back;
+
+	uint64_t end = next - back;		// One past the last line shown
+	uint64_t top = end - first > uint64_t(nrows) ? end - nrows : first;
+	uint64_t n = end - top;
+	int64_t delta = int64_t(top - shown_top);
+
+	if ( nrows != shown_rows || ncols != shown_cols )
+		redrawf = true;			// Resized
+	else if ( !redrawf && n < shown_n )
+		redrawf = true;			// Lines were dropped from view
+	if ( !redrawf && delta != 0 ) {
+		if ( n == uint64_t(nrows) && shown_n == n && delta > -nrows && delta < nrows ) {
+			w->scroll(int(delta));
+			++statistics.scrolls;
+		} else	redrawf = true;
+	}
+	if ( redrawf ) {
+		w->erase();
+		shown_n = 0;
+		++statistics.redraws;
+	}
+
+	for ( uint64_t r=0; r<n; ++r ) {
+		uint64_t seq = top + r;
+
+		if ( seq >= shown_top && seq < shown_top + shown_n )
+			continue;			// Still on display
+		draw_line(short(r),seq,ncols);
+	}
+
+	shown_top = top;
+	shown_n = n;
+	shown_rows = nrows;
+	shown_cols = ncols;
+	redrawf = false;
+	return *this;
+}
+
+// End logwin.cpp
@@ -0,0 +1,369 @@
+//////////////////////////////////////////////////////////////////////
+// renderq.cpp -- C++ NCurses Class Library -- Render command queue
+// Date: Sun Oct 18 03:57:55 2026   (C) ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include <algorithm>
+
+#include <cppcurses/renderq.hpp>
+
+static std::mutex queues_mutex;			// Guards queues
+static std::vector<RenderQueue*> queues;	// Live queues, for thread exit
+static std::atomic<uint64_t> next_id{1};
+
+//////////////////////////////////////////////////////////////////////
+// The rings claimed by a thread. When the thread exits, they are
+// released, so that other threads can take them over.
+//////////////////////////////////////////////////////////////////////
+
+struct RenderProducer {
+	struct Entry {
+		uint64_t		id;	// Queue's id
+		RenderQueue::Ring	*ring;
+	};
+
+	std::vector<Entry>	entries;
+
+	~RenderProducer() {
+		std::lock_guard<std::mutex> lock(queues_mutex);
+
+		for ( auto& e : entries )
+			for ( RenderQueue *q : queues )
+				if ( q->id == e.id ) {
+					std::lock_guard<std::mutex> qlock(q->mutex);
+					e.ring->owned.store(false,std::memory_order_relaxed);
+				}
+	}
+};
+
+static thread_local RenderProducer producer;
+static thread_local uint64_t last_id = 0;	// Last queue posted to
+static thread_local void *last_ring = nullptr;	// and this thread's ring
+
+RenderQueue::RenderQueue(CppCurses& curses,unsigned slots) : curses(curses), id(next_id++) {
+
+	nslots = 2;
+	while ( nslots < slots )
+		nslots <<= 1;
+
+	std::lock_guard<std::mutex> lock(queues_mutex);
+	queues.push_back(this);
+}
+
+RenderQueue::~RenderQueue() {
+	{
+		std::lock_guard<std::mutex> lock(queues_mutex);
+		queues.erase(std::find(queues.begin(),queues.end(),this));
+	}
+
+	unsigned n = nrings.load(std::memory_order_acquire);
+
+	for ( unsigned x=0; x<n; ++x )
+		delete rings[x].load(std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return the calling thread's ring, claiming one on first use
+//////////////////////////////////////////////////////////////////////
+
+RenderQueue::Ring *
+RenderQueue::ring() {
+
+	if ( last_id == id )
+		return (Ring*)last_ring;
+	for ( auto& e : producer.entries )
+		if ( e.id == id ) {
+			last_id = id;
+			last_ring = e.ring;
+			return e.ring;
+		}
+	return claim();
+}
+
+RenderQueue::Ring *
+RenderQueue::claim() {
+	std::lock_guard<std::mutex> lock(mutex);
+	unsigned n = nrings.load(std::memory_order_relaxed);
+	Ring *r = nullptr;
+
+	for ( unsigned x=0; x<n && !r; ++x ) {
+		Ring *c = rings[x].load(std::memory_order_relaxed);
+
+		if ( !c->owned.load(std::memory_order_relaxed) )
+			r = c;				// Released by an exited thread
+	}
+	if ( !r ) {
+		if ( n >= max_rings )
+			return nullptr;
+		r = new Ring(nslots);
+		rings[n].store(r,std::memory_order_release);
+		nrings.store(n+1,std::memory_order_release);
+	}
+	r->owned.store(true,std::memory_order_relaxed);
+	producer.entries.push_back({id,r});
+	last_id = id;
+	last_ring = r;
+	return r;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Number of slots for a command with len bytes of payload
+//////////////////////////////////////////////////////////////////////
+
+uint32_t
+RenderQueue::slots_of(size_t len) {
+
+	if ( len <= sizeof Cmd::data )
+		return 1;
+	return 1 + uint32_t((len - sizeof Cmd::data + sizeof(Cmd) - 1) / sizeof(Cmd));
+}
+
+//////////////////////////////////////////////////////////////////////
+// Reserve n consecutive slots (which may wrap), returning the first,
+// or nullptr if the ring is full. commit() publishes them.
+//////////////////////////////////////////////////////////////////////
+
+RenderQueue::Cmd *
+RenderQueue::reserve(Ring *r,uint32_t n) {
+	uint32_t t = r->tail.load(std::memory_order_relaxed);
+
+	if ( t - r->head_cache + n > nslots ) {
+		r->head_cache = r->head.load(std::memory_order_acquire);
+		if ( t - r->head_cache + n > nslots ) {
+			r->dropped.store(r->dropped.load(std::memory_order_relaxed)+1,std::memory_order_relaxed);
+			return nullptr;
+		}
+	}
+	return &r->slots[t & r->mask];
+}
+
+void
+RenderQueue::commit(Ring *r,uint32_t n) {
+
+	r->tail.store(r->tail.load(std::memory_order_relaxed)+n,std::memory_order_release);
+	r->posted.store(r->posted.load(std::memory_order_relaxed)+1,std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Post a command with a payload
+//////////////////////////////////////////////////////////////////////
+
+bool
+RenderQueue::post(Window *w,Cmd::Op op,short y,short x,const void *data,size_t len) {
+	Ring *r = ring();
+	uint32_t n = slots_of(len);
+	Cmd *cmd;
+
+	if ( !r || n > nslots || !(cmd = reserve(r,n)) )
+		return false;
+
+	size_t k = len < sizeof cmd->data ? len : sizeof cmd->data;
+	uint32_t t = r->tail.load(std::memory_order_relaxed);
+
+	cmd->win = w;
+	cmd->op = op;
+	cmd->y = y;
+	cmd->x = x;
+	cmd->len = uint32_t(len);
+	if ( k > 0 )				// data may be nullptr
+		memcpy(cmd->data,data,k);
+	for ( uint32_t s=1; s<n; ++s ) {
+		size_t m = len - k < sizeof(Cmd) ? len - k : sizeof(Cmd);
+
+		memcpy((void*)&r->slots[(t + s) & r->mask],(const char*)data + k,m);
+		k += m;
+	}
+	commit(r,n);
+	return true;
+}
+
+bool
+RenderQueue::move(Window *w,short y,short x) {
+	return post(w,Cmd::Move,y,x,nullptr,0);
+}
+
+bool
+RenderQueue::addstr(Window *w,std::string_view str) {
+	return post(w,Cmd::Text,-1,-1,str.data(),str.size());
+}
+
+bool
+RenderQueue::mvaddstr(Window *w,short y,short x,std::string_view str) {
+	return post(w,Cmd::Text,y,x,str.data(),str.size());
+}
+
+bool
+RenderQueue::blit(Window *w,short y,short x,std::span<const Cell> cells) {
+	return post(w,Cmd::Blit,y,x,cells.data(),cells.size_bytes());
+}
+
+bool
+RenderQueue::attr_set(Window *w,Attrs attrs,Window::colpair_t pair) {
+	Ring *r = ring();
+	Cmd *cmd;
+
+	if ( !r || !(cmd = reserve(r,1)) )
+		return false;
+	cmd->win = w;
+	cmd->op = Cmd::AttrSet;
+	cmd->len = 0;
+	cmd->attr.attrs = attrs.bits;
+	cmd->attr.pair = pair;
+	commit(r,1);
+	return true;
+}
+
+bool
+RenderQueue::erase(Window *w) {
+	return post(w,Cmd::Erase,0,0,nullptr,0);
+}
+
+bool
+RenderQueue::clear(Window *w) {
+	return post(w,Cmd::Clear,0,0,nullptr,0);
+}
+
+bool
+RenderQueue::call(void (*fn)(void *arg),void *arg) {
+	Ring *r = ring();
+	Cmd *cmd;
+
+	if ( !r || !(cmd = reserve(r,1)) )
+		return false;
+	cmd->win = nullptr;
+	cmd->op = Cmd::Call;
+	cmd->len = 0;
+	cmd->call.fn = fn;
+	cmd->call.arg = arg;
+	commit(r,1);
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return a command's payload, gathered into scratch if it continues
+// beyond the first slot
+//////////////////////////////////////////////////////////////////////
+
+const char *
+RenderQueue::payload(Ring *r,uint32_t h,const Cmd& cmd) {
+
+	if ( cmd.len <= sizeof cmd.data )
+		return cmd.data;
+
+	size_t k = sizeof cmd.data;
+
+	scratch.resize(cmd.len);
+	memcpy(scratch.data(),cmd.data,k);
+	for ( uint32_t s=1; k < cmd.len; ++s ) {
+		size_t m = cmd.len - k < sizeof(Cmd) ? cmd.len - k : sizeof(Cmd);
+
+		memcpy(scratch.data() + k,(const void*)&r->slots[(h + s) & r->mask],m);
+		k += m;
+	}
+	return scratch.data();
+}
+
+void
+RenderQueue::apply(Ring *r,uint32_t h,const Cmd& cmd) {
+
+	switch ( cmd.op ) {
+	case Cmd::Move:
+		cmd.win->move(cmd.y,cmd.x);
+		break;
+	case Cmd::Text:
+		if ( cmd.y >= 0 )
+			cmd.win->move(cmd.y,cmd.x);
+		cmd.win->addstr(std::string_view(payload(r,h,cmd),cmd.len));
+		break;
+	case Cmd::Blit:
+		cells.resize(cmd.len / sizeof(Cell));
+		if ( !cells.empty() )
+			memcpy((void*)cells.data(),payload(r,h,cmd),cells.size() * sizeof(Cell));
+		cmd.win->blit(cmd.y,cmd.x,cells);
+		break;
+	case Cmd::AttrSet:
+		cmd.win->attr_set(Attrs(cmd.attr.attrs),cmd.attr.pair);
+		break;
+	case Cmd::Erase:
+		cmd.win->erase();
+		break;
+	case Cmd::Clear:
+		cmd.win->clear();
+		break;
+	case Cmd::Call:
+		cmd.call.fn(cmd.call.arg);
+		break;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Apply all pending commands (render thread only), returning the
+// number applied. The screen is not updated: see render().
+//////////////////////////////////////////////////////////////////////
+
+size_t
+RenderQueue::drain() {
+	unsigned n = nrings.load(std::memory_order_acquire);
+	size_t count = 0;
+
+	for ( unsigned x=0; x<n; ++x ) {
+		Ring *r = rings[x].load(std::memory_order_acquire);
+		uint32_t h = r->head.load(std::memory_order_relaxed);
+		uint32_t t = r->tail.load(std::memory_order_acquire);
+
+		if ( h == t )
+			continue;
+		while ( h != t ) {
+			const Cmd& cmd = r->slots[h & r->mask];
+
+			apply(r,h,cmd);
+			h += slots_of(cmd.len);
+			++count;
+		}
+		r->head.store(h,std::memory_order_release);
+	}
+	if ( count > 0 ) {
+		applied += count;
+		++batches;
+	}
+	return count;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Apply all pending commands as one frame, so that the screen is
+// updated at most once
+//////////////////////////////////////////////////////////////////////
+
+size_t
+RenderQueue::render() {
+	size_t n;
+
+	curses.begin_frame();
+	n = drain();
+	curses.end_frame();
+	return n;
+}
+
+RenderQueue::Stats
+RenderQueue::stats() {
+	unsigned n = nrings.load(std::memory_order_acquire);
+	Stats st;
+
+	for ( unsigned x=0; x<n; ++x ) {
+		Ring *r = rings[x].load(std::memory_order_acquire);
+
+		st.posted += r->posted.load(std::memory_order_relaxed);
+		st.dropped += r->dropped.load(std::memory_order_relaxed);
+		if ( r->owned.load(std::memory_order_relaxed) )
+			++st.producers;
+	}
+	st.applied = applied;
+	st.batches = batches;
+	return st;
+}
+
+// End renderq.cpp
@@ -0,0 +1,494 @@
+//////////////////////////////////////////////////////////////////////
+// screendiff.cpp -- C++ NCurses Class Library -- Diffing screen renderer
+// Date: Sun Oct 18 04:32:15 2026   (C) ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <wchar.h>
+#include <poll.h>
+#include <sys/uio.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCREENDIFF_X86 1
+#endif
+
+#include <algorithm>
+
+#include <cppcurses/screendiff.hpp>
+
+#include <curses.h>
+
+//////////////////////////////////////////////////////////////////////
+// Packed cells: bits 0-31 the character, 32-47 the attributes (the
+// A_ATTRIBUTES bits above the colour), 48-63 the colour pair. The
+// right half of a wide character is cont_char (with its attributes).
+//////////////////////////////////////////////////////////////////////
+
+static constexpr uint64_t cont_char = 0x80000000;
+static constexpr uint64_t acs_bit = uint64_t(A_ALTCHARSET >> 16) << 32;
+
+static inline uint64_t
+pack(uint32_t ch,attr_t attr,int pair) {
+	return uint64_t(ch) | uint64_t((attr >> 16) & 0xFFFF) << 32 | uint64_t(uint16_t(pair)) << 48;
+}
+
+static const uint64_t blank = pack(' ',0,0);
+
+//////////////////////////////////////////////////////////////////////
+// Row compare: the first and last cells that differ, if any
+//////////////////////////////////////////////////////////////////////
+
+typedef bool (*RowDiff)(const uint64_t *a,const uint64_t *b,int n,int& first,int& last);
+
+static bool
+diff_scalar(const uint64_t *a,const uint64_t *b,int n,int& first,int& last) {
+	int f = 0, l = n - 1;
+
+	while ( f < n && a[f] == b[f] )
+		++f;
+	if ( f >= n )
+		return false;
+	while ( a[l] == b[l] )
+		--l;
+	first = f;
+	last = l;
+	return true;
+}
+
+#ifdef SCREENDIFF_X86
+
+static bool
+diff_sse2(const uint64_t *a,const uint64_t *b,int n,int& first,int& last) {
+	int f = 0, l = n;
+
+	for ( ; f + 2 <= n; f += 2 ) {
+		__m128i x = _mm_loadu_si128((const __m128i*)(a + f));
+		__m128i y = _mm_loadu_si128((const __m128i*)(b + f));
+
+		if ( _mm_movemask_epi8(_mm_cmpeq_epi32(x,y)) != 0xFFFF )
+			break;
+	}
+	while ( f < n && a[f] == b[f] )
+		++f;
+	if ( f >= n )
+		return false;
+
+	for ( ; l - 2 > f; l -= 2 ) {
+		__m128i x = _mm_loadu_si128((const __m128i*)(a + l - 2));
+		__m128i y = _mm_loadu_si128((const __m128i*)(b + l - 2));
+
+		if ( _mm_movemask_epi8(_mm_cmpeq_epi32(x,y)) != 0xFFFF )
+			break;
+	}
+	for ( --l; a[l] == b[l]; --l )
+		;
+	first = f;
+	last = l;
+	return true;
+}
+
+__attribute__((target("avx2")))
+static bool
+diff_avx2(const uint64_t *a,const uint64_t *b,int n,int& first,int& last) {
+	int f = 0, l = n;
+
+	for ( ; f + 4 <= n; f += 4 ) {
+		__m256i x = _mm256_loadu_si256((const __m256i*)(a + f));
+		__m256i y = _mm256_loadu_si256((const __m256i*)(b + f));
+
+		if ( _mm256_movemask_epi8(_mm256_cmpeq_epi64(x,y)) != -1 )
+			break;
+	}
+	while ( f < n && a[f] == b[f] )
+		++f;
+	if ( f >= n )
+		return false;
+
+	for ( ; l - 4 > f; l -= 4 ) {
+		__m256i x = _mm256_loadu_si256((const __m256i*)(a + l - 4));
+		__m256i y = _mm256_loadu_si256((const __m256i*)(b + l - 4));
+
+		if ( _mm256_movemask_epi8(_mm256_cmpeq_epi64(x,y)) != -1 )
+			break;
+	}
+	for ( --l; a[l] == b[l]; --l )
+		;
+	first = f;
+	last = l;
+	return true;
+}
+
+#endif
+
+static const char *row_diff_name = "scalar";
+
+static RowDiff
+pick_row_diff() {
+
+#ifdef SCREENDIFF_X86
+	__builtin_cpu_init();
+	if ( __builtin_cpu_supports("avx2") ) {
+		row_diff_name = "avx2";
+		return diff_avx2;
+	}
+	if ( __builtin_cpu_supports("sse2") ) {
+		row_diff_name = "sse2";
+		return diff_sse2;
+	}
+#endif
+	return diff_scalar;
+}
+
+static const RowDiff row_diff = pick_row_diff();
+
+const char *
+ScreenDiff::simd() {
+	return row_diff_name;
+}
+
+ScreenDiff::ScreenDiff(int fd) : fd(fd) {
+}
+
+//////////////////////////////////////////////////////////////////////
+// Read row y of the composed screen into back[]. win_wchnstr()
+// returns one entry per character, leaving out the right halves of
+// wide characters, so a row holding wide characters is read again a
+// cell at a time: the low attribute bits tell a right half (> 1). A
+// left half that lost its right half to another character is shown
+// as a blank, as it would be by the terminal.
+//////////////////////////////////////////////////////////////////////
+
+void
+ScreenDiff::read_row(int y) {
+	cchar_t *buf = (cchar_t*)scratch.data();
+	int x = 0;
+
+	wmove(newscr,y,0);
+	win_wchnstr(newscr,buf,-1);
+
+	for ( int i=0; x < ncols; ++i ) {
+		const cchar_t& c = buf[i];
+		uint32_t ch = uint32_t(c.chars[0]);
+
+		if ( !ch )
+			break;				// End of the row
+		if ( ch >= 0x80 && wcwidth(wchar_t(ch)) == 2 )
+			break;				// See below
+		back[x++] = pack(ch < 0x20 ? ' ' : ch,c.attr,c.ext_color ? c.ext_color : PAIR_NUMBER(c.attr));
+	}
+	if ( x >= ncols )
+		return;
+
+	for ( int cx=0; cx < ncols; ++cx )
+		mvwin_wch(newscr,y,cx,&buf[cx]);
+
+	for ( x=0; x < ncols; ++x ) {
+		const cchar_t& c = buf[x];
+		uint32_t ch = uint32_t(c.chars[0]);
+		int pair = c.ext_color ? c.ext_color : PAIR_NUMBER(c.attr);
+
+		if ( (c.attr & A_CHARTEXT) > 1 )
+			ch = uint32_t(cont_char);
+		else if ( ch < 0x20 )
+			ch = ' ';
+		else if ( ch >= 0x80 && wcwidth(wchar_t(ch)) == 2
+		  && (x + 1 >= ncols || (buf[x+1].attr & A_CHARTEXT) <= 1) )
+			ch = ' ';			// Lost its right half
+		back[x] = pack(ch,c.attr,pair);
+	}
+}
+
+static void
+put_num(std::string& out,unsigned n) {
+	char buf[12];
+	char *p = buf + sizeof buf;
+
+	do	*--p = char('0' + n % 10);
+	while ( (n /= 10) > 0 );
+	out.append(p,buf + sizeof buf - p);
+}
+
+void
+ScreenDiff::put_move(int y,int x) {
+
+	if ( y == cur_y && x == cur_x )
+		return;
+	if ( y == cur_y && cur_x >= 0 && x > cur_x ) {
+		out.append("\033[");
+		if ( x - cur_x > 1 )
+			put_num(out,x - cur_x);
+		out += 'C';
+	} else	{
+		out.append("\033[");
+		put_num(out,y + 1);
+		if ( x > 0 ) {
+			out += ';';
+			put_num(out,x + 1);
+		}
+		out += 'H';
+	}
+	cur_y = y;
+	cur_x = x;
+}
+
+static void
+put_colour(std::string& out,int c,unsigned base) {
+
+	out += ';';
+	if ( c < 8 ) {
+		put_num(out,base + c);
+	} else if ( c < 16 ) {
+		put_num(out,base + 60 + c - 8);
+	} else if ( COLORS <= 256 ) {
+		put_num(out,base + 8);
+		out.append(";5;");
+		put_num(out,c);
+	} else	{
+		put_num(out,base + 8);
+		out.append(";2;");
+		put_num(out,(c >> 16) & 0xFF);
+		out += ';';
+		put_num(out,(c >> 8) & 0xFF);
+		out += ';';
+		put_num(out,c & 0xFF);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Select the attributes and colours of cell (from the normal state,
+// when they change at all)
+//////////////////////////////////////////////////////////////////////
+
+void
+ScreenDiff::put_sgr(uint64_t cell) {
+	uint64_t sgr = cell & ~uint64_t(0xFFFFFFFF) & ~acs_bit;
+	bool acs = (cell & acs_bit) != 0;
+
+	if ( sgr != cur_sgr ) {
+		attr_t attr = attr_t((sgr >> 32) & 0xFFFF) << 16;
+		int pair = int(sgr >> 48);
+
+		out.append("\033[0");
+		if ( attr & A_BOLD )
+			out.append(";1");
+		if ( attr & A_DIM )
+			out.append(";2");
+		if ( attr & A_ITALIC )
+			out.append(";3");
+		if ( attr & A_UNDERLINE )
+			out.append(";4");
+		if ( attr & A_BLINK )
+			out.append(";5");
+		if ( attr & (A_REVERSE|A_STANDOUT) )
+			out.append(";7");
+		if ( attr & A_INVIS )
+			out.append(";8");
+		if ( pair > 0 ) {
+			int fg, bg;
+
+			if ( extended_pair_content(pair,&fg,&bg) == OK ) {
+				if ( fg >= 0 )
+					put_colour(out,fg,30);
+				if ( bg >= 0 )
+					put_colour(out,bg,40);
+			}
+		}
+		out += 'm';
+		cur_sgr = sgr;
+	}
+	if ( acs != cur_acs ) {
+		out.append(acs ? "\033(0" : "\033(B");
+		cur_acs = acs;
+	}
+}
+
+void
+ScreenDiff::put_char(uint64_t cell) {
+	uint32_t ch = uint32_t(cell);
+	int width = 1;
+
+	if ( ch < 0x80 ) {
+		out += char(ch);
+	} else	{
+		char buf[8];
+
+		if ( ch < 0x800 ) {
+			buf[0] = char(0xC0 | ch >> 6);
+			buf[1] = char(0x80 | (ch & 0x3F));
+			out.append(buf,2);
+		} else if ( ch < 0x10000 ) {
+			buf[0] = char(0xE0 | ch >> 12);
+			buf[1] = char(0x80 | (ch >> 6 & 0x3F));
+			buf[2] = char(0x80 | (ch & 0x3F));
+			out.append(buf,3);
+		} else	{
+			buf[0] = char(0xF0 | ch >> 18);
+			buf[1] = char(0x80 | (ch >> 12 & 0x3F));
+			buf[2] = char(0x80 | (ch >> 6 & 0x3F));
+			buf[3] = char(0x80 | (ch & 0x3F));
+			out.append(buf,4);
+		}
+		if ( wcwidth(wchar_t(ch)) == 2 )
+			width = 2;
+	}
+	cur_x += width;
+	if ( cur_x >= ncols )
+		cur_y = cur_x = -1;		// Pending wrap: position unknown
+	++statistics.cells_written;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Write the changed cells first..last of row y. Runs of unchanged
+// cells are skipped with a cursor move, when they are long enough
+// for that to be shorter than rewriting them.
+//////////////////////////////////////////////////////////////////////
+
+void
+ScreenDiff::put_row(int y,int first,int last) {
+	uint64_t *f = front.data() + size_t(y) * ncols;
+	int x = first;
+
+	if ( x > 0 && uint32_t(back[x]) == cont_char )
+		--x;				// Start with the wide character
+
+	while ( x <= last ) {
+		if ( f[x] == back[x] ) {
+			int run = x;
+
+			while ( run <= last && f[run] == back[run] )
+				++run;
+			if ( run - x >= 6 ) {
+				x = run;
+				continue;
+			}
+		}
+		if ( uint32_t(back[x]) == cont_char ) {
+			f[x] = back[x];		// Written with its left half
+			++x;
+			continue;
+		}
+		put_move(y,x);
+		put_sgr(back[x]);
+		put_char(back[x]);
+		f[x] = back[x];
+		++x;
+		if ( x < ncols && uint32_t(back[x]) == cont_char ) {
+			f[x] = back[x];
+			++x;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Write the frame, between the DEC 2026 set and reset when syncing
+//////////////////////////////////////////////////////////////////////
+
+void
+ScreenDiff::flush() {
+	static const char sync_set[] = "\033[?2026h", sync_reset[] = "\033[?2026l";
+	iovec iov[3] = {
+		{ (void*)sync_set, sizeof sync_set - 1 },
+		{ out.data(), out.size() },
+		{ (void*)sync_reset, sizeof sync_reset - 1 },
+	};
+	iovec *v = syncf ? iov : iov + 1;
+	int nv = syncf ? 3 : 1;
+
+	while ( nv > 0 ) {
+		ssize_t rc = ::writev(fd,v,nv);
+
+		if ( rc < 0 ) {
+			if ( errno == EAGAIN || errno == EWOULDBLOCK ) {
+				pollfd pfd = { fd, POLLOUT, 0 };
+
+				poll(&pfd,1,-1);	// Non-blocking: wait for room
+				continue;
+			}
+			if ( errno == EINTR )
+				continue;
+			break;
+		}
+		while ( nv > 0 && size_t(rc) >= v->iov_len ) {
+			rc -= v->iov_len;
+			++v;
+			--nv;
+		}
+		if ( nv > 0 ) {
+			v->iov_base = (char*)v->iov_base + rc;
+			v->iov_len -= rc;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Bring the terminal up to date with the composed screen (after
+// update_panels()), in place of doupdate()
+//////////////////////////////////////////////////////////////////////
+
+void
+ScreenDiff::update() {
+	int rows = getmaxy(newscr), cols = getmaxx(newscr);
+	int cy = getcury(newscr), cx = getcurx(newscr);
+
+	if ( rows != nrows || cols != ncols ) {
+		nrows = rows;
+		ncols = cols;
+		front.resize(size_t(rows) * cols);
+		back.resize(cols);
+		scratch.resize((size_t(cols) + 1) * sizeof(cchar_t));
+		fullf = true;
+	}
+	if ( is_cleared(newscr) || is_cleared(curscr) ) {
+		clearok(newscr,FALSE);
+		clearok(curscr,FALSE);
+		fullf = true;
+	}
+
+	out.clear();
+	if ( fullf ) {
+		out.append("\033[0m\033(B\033[H\033[2J");
+		std::fill(front.begin(),front.end(),blank);
+		cur_sgr = 0;
+		cur_acs = false;
+		cur_y = cur_x = 0;
+		++statistics.repaints;
+	}
+
+	for ( int y=0; y<nrows; ++y ) {
+		int first, last;
+
+		if ( !fullf && !is_linetouched(newscr,y) )
+			continue;
+		read_row(y);
+		++statistics.rows_compared;
+		if ( row_diff(front.data() + size_t(y) * ncols,back.data(),ncols,first,last) ) {
+			put_row(y,first,last);
+			++statistics.rows_changed;
+		}
+	}
+
+	if ( cur_sgr ) {
+		out.append("\033[0m");
+		cur_sgr = 0;
+	}
+	if ( cur_acs ) {
+		out.append("\033(B");
+		cur_acs = false;
+	}
+	if ( !is_leaveok(newscr) )
+		put_move(cy,cx);
+
+	wmove(newscr,cy,cx);
+	untouchwin(newscr);
+	fullf = false;
+	++statistics.frames;
+	if ( !out.empty() )
+		flush();
+}
+
+// End screendiff.cpp
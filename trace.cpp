@@ -0,0 +1,141 @@
+//////////////////////////////////////////////////////////////////////
+// trace.cpp -- C++ NCurses Class Library -- Hot path tracing
+// Date: Sun Oct 18 04:22:52 2026   (C) ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+
+#include <mutex>
+#include <vector>
+
+#include <cppcurses/trace.hpp>
+
+static std::mutex rings_mutex;				// Guards claims and dumps
+static std::atomic<Trace::Ring*> rings[Trace::max_rings];
+static std::atomic<unsigned> nrings{0};
+static std::atomic<int64_t> cleared{0};			// Events before are forgotten
+
+//////////////////////////////////////////////////////////////////////
+// Releases the thread's ring when the thread exits, so that another
+// thread can take it over (the events recorded so far are kept)
+//////////////////////////////////////////////////////////////////////
+
+struct TraceOwner {
+	Trace::Ring	*ring = nullptr;
+
+	~TraceOwner() {
+		if ( ring )
+			ring->owned.store(false,std::memory_order_release);
+	}
+};
+
+static thread_local TraceOwner owner;
+
+Trace::Ring *
+Trace::claim() {
+	std::lock_guard<std::mutex> lock(rings_mutex);
+	unsigned n = nrings.load(std::memory_order_relaxed);
+	Ring *r = nullptr;
+
+	for ( unsigned x=0; x<n && !r; ++x ) {
+		Ring *f = rings[x].load(std::memory_order_relaxed);
+
+		if ( !f->owned.load(std::memory_order_acquire) )
+			r = f;
+	}
+	if ( !r ) {
+		if ( n >= max_rings )
+			return nullptr;
+		r = new Ring;
+		rings[n].store(r,std::memory_order_relaxed);
+		nrings.store(n + 1,std::memory_order_release);
+	}
+
+	r->owned.store(true,std::memory_order_relaxed);
+	r->tid = gettid();
+	owner.ring = local = r;
+	return r;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Write the recorded events as a Chrome trace ("X" complete events,
+// times in microseconds). The rings are not stopped: events that
+// were overwritten while they were being copied are left out.
+//////////////////////////////////////////////////////////////////////
+
+size_t
+Trace::dump(FILE *fp) {
+	struct Copy {
+		const char	*name;
+		int64_t		ts, dur;
+		int		tid;
+	};
+	std::lock_guard<std::mutex> lock(rings_mutex);
+	unsigned n = nrings.load(std::memory_order_acquire);
+	int64_t since = cleared.load(std::memory_order_relaxed);
+	std::vector<Copy> copies;
+	int pid = getpid();
+	size_t count = 0;
+
+	fputs("{\"traceEvents\":[\n",fp);
+	for ( unsigned x=0; x<n; ++x ) {
+		Ring *r = rings[x].load(std::memory_order_relaxed);
+		uint64_t end = r->pos.load(std::memory_order_acquire);
+		uint64_t start = end > ring_events ? end - ring_events : 0;
+
+		copies.clear();
+		for ( uint64_t p=start; p<end; ++p ) {
+			const Event& ev = r->events[p & (ring_events - 1)];
+
+			copies.push_back({
+				ev.name.load(std::memory_order_relaxed),
+				ev.ts.load(std::memory_order_relaxed),
+				ev.dur.load(std::memory_order_relaxed),
+				ev.tid.load(std::memory_order_relaxed)
+			});
+		}
+
+		// The copies are ordered before pos is read again. Slot now &
+		// mask may be part way through being written (pos is bumped
+		// after), so the event it held is left out too.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t now = r->pos.load(std::memory_order_relaxed);
+		uint64_t valid = now + 1 > ring_events ? now + 1 - ring_events : 0;
+
+		for ( uint64_t p=start; p<end; ++p ) {
+			const Copy& c = copies[p - start];
+
+			if ( p < valid || c.ts < since || !c.name )
+				continue;
+			fprintf(fp,"%s{\"name\":\"%s\",\"cat\":\"cppcurses\",\"ph\":\"X\","
+				"\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d}",
+				count ? ",\n" : "",c.name,c.ts / 1e3,c.dur / 1e3,pid,c.tid);
+			++count;
+		}
+	}
+	fputs("\n],\"displayTimeUnit\":\"ns\"}\n",fp);
+	fflush(fp);
+	return count;
+}
+
+size_t
+Trace::dump(const char *path) {
+	FILE *fp = fopen(path,"w");
+	size_t count;
+
+	if ( !fp )
+		return 0;
+	count = dump(fp);
+	fclose(fp);
+	return count;
+}
+
+void
+Trace::clear() {
+	cleared.store(now(),std::memory_order_relaxed);
+}
+
+// End trace.cpp
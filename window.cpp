@@ -12,29 +12,53 @@
 #include <sched.h>
 #include <stdint.h>
 #include <assert.h>
+#include <wchar.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include <cppcurses/cppcurses.hpp>
+#include <cppcurses/trace.hpp>
 
+#define NCURSES_WIDECHAR 1		// cchar_t and the wide character API
 #include <curses.h>
 #include <panel.h>
 
-#include <map>
+#include <algorithm>
 #include <array>
+#include <vector>
 
-static const std::map<char,attr_t> attr_map({
-	{ 'N',	A_NORMAL },		// Normal display (no highlight)
-	{ 'S',	A_STANDOUT },		// Best highlighting mode of the terminal.
-	{ 'U',	A_UNDERLINE },		// Underlining
-	{ 'R',	A_REVERSE },		// Reverse video
-	{ 'b',	A_BLINK },		// Blinking
-	{ 'D',	A_DIM },		// Half bright
-	{ 'B',	A_BOLD },		// Extra bright or bold
-	{ 'A',	A_ALTCHARSET },		// Alternate character set
-});
+//////////////////////////////////////////////////////////////////////
+// The lookup tables below are directly indexed arrays, so that the
+// per character and per key lookups are a single load.
+//////////////////////////////////////////////////////////////////////
+
+static constexpr std::array<attr_t,128>
+make_attr_map() {
+	std::array<attr_t,128> map{};
+
+	map['N'] = A_NORMAL;		// Normal display (no highlight)
+	map['S'] = A_STANDOUT;		// Best highlighting mode of the terminal.
+	map['U'] = A_UNDERLINE;		// Underlining
+	map['R'] = A_REVERSE;		// Reverse video
+	map['b'] = A_BLINK;		// Blinking
+	map['D'] = A_DIM;		// Half bright
+	map['B'] = A_BOLD;		// Extra bright or bold
+	map['A'] = A_ALTCHARSET;	// Alternate character set
+	return map;
+}
+
+static constexpr std::array<attr_t,128> attr_map = make_attr_map();
 
-static std::map<char,chtype> graph_map;	// This must be initialized after initscr()
+static_assert(Attrs::Standout == A_STANDOUT && Attrs::Underline == A_UNDERLINE
+	&& Attrs::Reverse == A_REVERSE && Attrs::Blink == A_BLINK && Attrs::Dim == A_DIM
+	&& Attrs::Bold == A_BOLD && Attrs::Altcharset == A_ALTCHARSET,
+	"Attrs bits must match curses");
 
-static const std::array<short,8> colour_map({
+static std::array<chtype,128> graph_map;	// This must be initialized after initscr() (0 = none)
+
+static constexpr std::array<short,8> colour_map({
 	COLOR_BLACK,
 	COLOR_BLUE,
 	COLOR_GREEN,
@@ -45,11 +69,26 @@ static const std::array<short,8> colour_map({
 	COLOR_WHITE
 });
 
-static std::map<short/*colorno*/,short/*pair*/> pair_map;
-static std::map<short/*pair*/,short/*colourno*/> rev_pair;
+static constexpr std::array<short,8>
+make_rev_colour_map() {
+	std::array<short,8> map{};
+
+	for ( short x=0; x<8; ++x )
+		map[colour_map[x]] = x;
+	return map;
+}
+
+static constexpr std::array<short,8> rev_colour_map = make_rev_colour_map();	// Curses colour to Colour
 
-static std::map<Key,uint32_t> rkeymap;
-static std::map<uint32_t,Key> keymap({
+static std::array<short/*pair*/,64> pair_map;		// Indexed by colourno
+static std::array<uint8_t/*colourno*/,64> rev_pair;	// Indexed by pair
+
+struct KeyPair {
+	int	ikey;		// Curses KEY_*
+	Key	key;
+};
+
+static constexpr KeyPair keylist[] = {
 #ifdef KEY_BREAK
 	{ KEY_BREAK,	Key::Break }, 
 #endif
@@ -340,7 +379,37 @@ static std::map<uint32_t,Key> keymap({
 #ifdef KEY_EVENT
 	{ KEY_EVENT,	Key::Event }, 
 #endif
-});
+};
+
+//////////////////////////////////////////////////////////////////////
+// keymap translates KEY_MIN..KEY_MAX to Key (-1 when not mapped)
+// and rkeymap tells which Key values are supported.
+//////////////////////////////////////////////////////////////////////
+
+static constexpr int nkeys = int(Key::Event) + 1;
+
+static constexpr std::array<int16_t,KEY_MAX-KEY_MIN+1>
+make_keymap() {
+	std::array<int16_t,KEY_MAX-KEY_MIN+1> map{};
+
+	for ( auto& entry : map )
+		entry = -1;
+	for ( auto& kp : keylist )
+		map[kp.ikey-KEY_MIN] = int16_t(kp.key);
+	return map;
+}
+
+static constexpr std::array<bool,nkeys>
+make_rkeymap() {
+	std::array<bool,nkeys> map{};
+
+	for ( auto& kp : keylist )
+		map[int(kp.key)] = true;
+	return map;
+}
+
+static constexpr std::array<int16_t,KEY_MAX-KEY_MIN+1> keymap = make_keymap();
+static constexpr std::array<bool,nkeys> rkeymap = make_rkeymap();
 
 static inline void
 curs_visibility(void *win,int flag) {
@@ -370,14 +439,14 @@ curs_colorno(short bg,short fg) {
 
 static inline short
 curs_background(Window::colpair_t pair) {
-	short colourno = rev_pair.at(pair);
-	return (colourno >> 3) & 7;
+	assert(pair >= 0 && pair < 64);
+	return rev_pair[pair] & 7;
 }
 
 static inline short
 curs_foreground(Window::colpair_t pair) {
-	short colourno = rev_pair.at(pair);
-	return colourno & 7;
+	assert(pair >= 0 && pair < 64);
+	return (rev_pair[pair] >> 3) & 7;
 }
 
 static inline void
@@ -386,13 +455,12 @@ curs_wmove(void *win,short y,short x) {
 }
 
 static inline int
-curs_getch() {
-	int ikey = wgetch(stdscr);
+curs_getch(void *win) {
+	int ikey = wgetch((WINDOW*)win);
 
-	auto it = keymap.find(ikey);
-	if ( it == keymap.end() )
+	if ( ikey < KEY_MIN || ikey > KEY_MAX || keymap[ikey-KEY_MIN] < 0 )
 		return ikey;		// Return ASCII
-	return int(it->second);		// Return Key::*
+	return keymap[ikey-KEY_MIN];	// Return Key::*
 }
 
 #undef wgetch
@@ -400,12 +468,297 @@ curs_getch() {
 #undef curs_set
 
 //////////////////////////////////////////////////////////////////////
-// Static method to initialize graph_map
+// Colour pairs beyond the 64 fixed pairs of Colour are allocated on
+// demand, from a cache that recycles the least recently used pair
+// once the terminal's (or CppCurses::pair_limit()) limit is reached.
+// A pair held by a window (as its colours, or its frame's) is never
+// recycled: when every pair is held, the default pair is returned.
+// Entry x always owns pair base+x, so the colours of a cached pair
+// are found without a search. Lookups are a hash probe, and nothing
+// is allocated after init().
+//////////////////////////////////////////////////////////////////////
+
+class PairCache {
+	static constexpr uint32_t none = ~0u;
+
+	struct Entry {
+		uint64_t	key;		// fg << 32 | bg
+		uint32_t	prev;		// LRU list (towards head)
+		uint32_t	next;		// LRU list (towards tail)
+		uint32_t	chain;		// Hash bucket chain
+		uint32_t	refs;		// Windows holding the pair
+	};
+
+	std::vector<Entry>	entries;
+	std::vector<uint32_t>	buckets;
+	unsigned		shift = 64;	// 64 - log2(buckets)
+	uint32_t		used = 0;
+	uint32_t		head = none;	// Most recently used
+	uint32_t		tail = none;	// Least recently used
+	short			base = 0;	// Pair of entries[0]
+
+	static uint64_t key_of(int fg,int bg) { return uint64_t(uint32_t(fg)) << 32 | uint32_t(bg); }
+	uint32_t bucket(uint64_t key) const { return uint32_t((key * 0x9E3779B97F4A7C15ull) >> shift); }
+
+	void unlink(uint32_t x);
+	void push_front(uint32_t x);
+	void unchain(uint32_t x);
+
+public:	void init(short base,unsigned capacity);
+	short pair(int fg,int bg,CppCurses::Stats& stats);
+	bool colours(short pair,int& fg,int& bg) const;
+	void hold(short pair);
+	void release(short pair);
+};
+
+static PairCache pair_cache;
+
+void
+PairCache::init(short base,unsigned capacity) {
+	unsigned nbuckets = 1;
+
+	this->base = base;
+	entries.assign(capacity,Entry());
+	shift = 64;
+	while ( nbuckets < capacity * 2 ) {
+		nbuckets <<= 1;
+		--shift;
+	}
+	if ( shift == 64 ) {
+		nbuckets = 2;		// Avoid a shift by 64
+		shift = 63;
+	}
+	buckets.assign(nbuckets,none);
+	used = 0;
+	head = tail = none;
+}
+
+void
+PairCache::unlink(uint32_t x) {
+	Entry& e = entries[x];
+
+	if ( e.prev != none )
+		entries[e.prev].next = e.next;
+	else	head = e.next;
+	if ( e.next != none )
+		entries[e.next].prev = e.prev;
+	else	tail = e.prev;
+}
+
+void
+PairCache::push_front(uint32_t x) {
+	Entry& e = entries[x];
+
+	e.prev = none;
+	e.next = head;
+	if ( head != none )
+		entries[head].prev = x;
+	head = x;
+	if ( tail == none )
+		tail = x;
+}
+
+void
+PairCache::unchain(uint32_t x) {
+	uint32_t *link = &buckets[bucket(entries[x].key)];
+
+	while ( *link != x )
+		link = &entries[*link].chain;
+	*link = entries[x].chain;
+}
+
+short
+PairCache::pair(int fg,int bg,CppCurses::Stats& stats) {
+	uint64_t key = key_of(fg,bg);
+	uint32_t b = bucket(key), x;
+
+	if ( entries.empty() )
+		return 0;			// No pairs to allocate
+
+	for ( x = buckets[b]; x != none; x = entries[x].chain ) {
+		if ( entries[x].key == key ) {
+			if ( x != head ) {
+				unlink(x);
+				push_front(x);
+			}
+			return base + x;
+		}
+	}
+
+	if ( used < entries.size() ) {
+		x = used++;
+	} else	{
+		x = tail;			// Recycle the LRU pair not held
+		while ( x != none && entries[x].refs > 0 )
+			x = entries[x].prev;
+		if ( x == none )
+			return 0;
+		unlink(x);
+		unchain(x);
+		++stats.pair_evictions;
+	}
+
+	entries[x].key = key;
+	entries[x].chain = buckets[b];
+	buckets[b] = x;
+	push_front(x);
+	init_extended_pair(base + x,fg,bg);
+	++stats.pair_allocs;
+	return base + x;
+}
+
+bool
+PairCache::colours(short pair,int& fg,int& bg) const {
+	uint32_t x = uint32_t(pair - base);
+
+	if ( pair < base || x >= used )
+		return false;
+	fg = int(entries[x].key >> 32);
+	bg = int(uint32_t(entries[x].key));
+	return true;
+}
+
+void
+PairCache::hold(short pair) {
+	uint32_t x = uint32_t(pair - base);
+
+	if ( pair >= base && x < used )
+		++entries[x].refs;
+}
+
+void
+PairCache::release(short pair) {
+	uint32_t x = uint32_t(pair - base);
+
+	if ( pair >= base && x < used && entries[x].refs > 0 )
+		--entries[x].refs;
+}
+
+//////////////////////////////////////////////////////////////////////
+// The xterm 16 colour palette, and its 6x6x6 cube levels
+//////////////////////////////////////////////////////////////////////
+
+static constexpr Rgb xterm16[16] = {
+	{ 0, 0, 0 },	{ 205, 0, 0 },	{ 0, 205, 0 },	{ 205, 205, 0 },
+	{ 0, 0, 238 },	{ 205, 0, 205 },	{ 0, 205, 205 },	{ 229, 229, 229 },
+	{ 127, 127, 127 },	{ 255, 0, 0 },	{ 0, 255, 0 },	{ 255, 255, 0 },
+	{ 92, 92, 255 },	{ 255, 0, 255 },	{ 0, 255, 255 },	{ 255, 255, 255 }
+};
+
+static constexpr uint8_t cube_levels[6] = { 0, 95, 135, 175, 215, 255 };
+
+static inline int
+rgb_distance(Rgb a,Rgb b) {
+	int dr = a.r - b.r, dg = a.g - b.g, db = a.b - b.b;
+
+	return dr * dr + dg * dg + db * db;
+}
+
+static Rgb
+xterm_rgb(int index) {
+
+	if ( index < 16 )
+		return xterm16[index];
+	if ( index < 232 ) {
+		index -= 16;
+		return Rgb(cube_levels[index / 36],cube_levels[index / 6 % 6],cube_levels[index % 6]);
+	}
+	uint8_t grey = 8 + (index - 232) * 10;
+	return Rgb(grey,grey,grey);
+}
+
+static int
+nearest_of(Rgb c,int ncolours) {
+	int best = 0, bestd = rgb_distance(c,xterm16[0]);
+
+	for ( int x=1; x<ncolours; ++x ) {
+		int d = rgb_distance(c,xterm16[x]);
+		if ( d < bestd ) {
+			best = x;
+			bestd = d;
+		}
+	}
+	return best;
+}
+
+static inline int
+cube_index(uint8_t v) {
+	return v < 48 ? 0 : v < 115 ? 1 : (v - 35) / 40;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return the curses colour number for an RGB colour
+//////////////////////////////////////////////////////////////////////
+
+static int
+curs_rgb(Rgb c) {
+
+	if ( COLORS >= 0x1000000 ) {
+		int v = int(c.value());
+		return v < 8 ? 0 : v;		// Direct colour (< 8 are ANSI)
+	}
+	if ( COLORS >= 256 ) {
+		int r = cube_index(c.r), g = cube_index(c.g), b = cube_index(c.b);
+		int cube = 16 + r * 36 + g * 6 + b;
+		int avg = (c.r + c.g + c.b) / 3;
+		int grey = avg > 238 ? 23 : avg < 8 ? 0 : (avg - 8) / 10;
+
+		if ( rgb_distance(c,xterm_rgb(232 + grey)) < rgb_distance(c,xterm_rgb(cube)) )
+			return 232 + grey;
+		return cube;
+	}
+	return nearest_of(c,COLORS >= 16 ? 16 : 8);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return the curses colour number for a palette index
+//////////////////////////////////////////////////////////////////////
+
+static inline int
+curs_index(int index) {
+
+	if ( index < 0 )
+		return 0;
+	if ( index < COLORS )
+		return index;
+	return curs_rgb(xterm_rgb(index < 256 ? index : 255));
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return the pair for curses colour numbers fg and bg: one of the
+// fixed pairs when both are among the first 8, else a cached pair.
+//////////////////////////////////////////////////////////////////////
+
+static inline short
+curs_pair(int fg,int bg,CppCurses::Stats& stats) {
+
+	if ( unsigned(fg) < 8 && unsigned(bg) < 8 )
+		return Window::to_pair(Colour(rev_colour_map[fg]),Colour(rev_colour_map[bg]));
+	return pair_cache.pair(fg,bg,stats);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return the curses colour numbers of a pair
+//////////////////////////////////////////////////////////////////////
+
+static inline void
+curs_pair_colours(short pair,int& fg,int& bg) {
+
+	if ( pair >= 0 && pair < 64 ) {
+		fg = colour_map[(rev_pair[pair] >> 3) & 7];
+		bg = colour_map[rev_pair[pair] & 7];
+	} else if ( !pair_cache.colours(pair,fg,bg) ) {
+		fg = COLOR_WHITE;
+		bg = COLOR_BLACK;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Static method to initialize graph_map and the colour pairs
 //////////////////////////////////////////////////////////////////////
 
 void
-Window::init_maps(bool colour) {
-	short pairno = 0;
+Window::init_maps(bool colour,unsigned max_pairs) {
 
 	graph_map['L'] = ACS_ULCORNER;
 	graph_map['l'] = ACS_LLCORNER;
@@ -423,17 +776,20 @@ Window::init_maps(bool colour) {
 		for ( short bg = 0; bg < 8; ++bg ) {
 			for ( short fg= 0; fg < 8; ++fg ) {
 				short colour_no = curs_colorno(fg,bg);
-				short pair = pairno++;
+				short pair = to_pair(Colour(fg),Colour(bg));
 				init_pair(pair,colour_map[fg],colour_map[bg]);
 				pair_map[colour_no] = pair;
 				rev_pair[pair] = colour_no;
 			}
 		}
-	}
 
-	// Populate the reverse key map
-	for ( auto& pair : keymap )
-		rkeymap[pair.second] = pair.first;
+		// Remaining pairs are allocated on demand
+		int npairs = COLOR_PAIRS < 0x7FFF ? COLOR_PAIRS : 0x7FFF;
+
+		if ( max_pairs && int(max_pairs) < npairs )
+			npairs = int(max_pairs);
+		pair_cache.init(64,npairs > 64 ? npairs - 64 : 0);
+	}
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -444,9 +800,7 @@ Window::colpair_t
 Window::to_colour(Colour fg,Colour bg) {
 	short colour_no = curs_colorno(short(fg),short(bg));
 
-	auto it = pair_map.find(colour_no);
-	assert(it != pair_map.end());
-	return colpair_t(it->second);
+	return colpair_t(pair_map[colour_no & 63]);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -461,11 +815,8 @@ to_attrs(const char *attrstr) {
 	if ( !attrstr || !*attrstr )
 		return A_NORMAL;
 
-	while ( (ch = *attrstr++) != 0 ) {
-		auto it = attr_map.find(ch);
-		if ( it != attr_map.end() )
-			attrs |= it->second;
-	}
+	while ( (ch = *attrstr++) != 0 )
+		attrs |= ch & 0x80 ? 0 : attr_map[ch];
 	return attrs;
 }
 
@@ -475,8 +826,8 @@ curs_wattr_on(void *win,attr_t a) {
 }
 
 static inline void
-curs_wattron(void *win,Window::colpair_t colour) {
-	wattron((WINDOW*)win,COLOR_PAIR(colour));
+curs_wcolor_set(void *win,Window::colpair_t colour) {
+	wcolor_set((WINDOW*)win,colour,nullptr);
 }
 
 static inline void
@@ -486,8 +837,7 @@ curs_wattr_off(void *win,attr_t a) {
 
 static inline void
 curs_wattr_set(void *win,attr_t a,int pair) {
-	wattrset((WINDOW*)win,a);
-	wcolor_set((WINDOW*)win,pair,nullptr);
+	wattr_set((WINDOW*)win,a,pair,nullptr);
 }
 
 static inline void
@@ -495,9 +845,251 @@ curs_waddch(void *win,chtype ch) {
 	waddch((WINDOW*)win,ch);
 }
 
+//////////////////////////////////////////////////////////////////////
+// Fill a curses cchar_t with one character (the pair is stored in
+// full, so that pairs beyond 255 are kept)
+//////////////////////////////////////////////////////////////////////
+
+static inline void
+curs_setcc(cchar_t& cc,wchar_t wch,attr_t a,int pair) {
+#if defined(NCURSES_EXT_COLORS)
+	cc.attr = a | COLOR_PAIR(pair & 0xFF);		// As setcchar()
+	cc.chars[0] = wch;
+	cc.chars[1] = 0;
+	cc.ext_color = pair;
+#else
+	wchar_t wstr[2] = { wch, 0 };
+
+	setcchar(&cc,wstr,a,short(pair),&pair);
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////
+// Set a window's background of blanks (wbkgd() would keep only the
+// low 8 bits of the pair)
+//////////////////////////////////////////////////////////////////////
+
+static inline void
+curs_wbkgd(void *win,attr_t a,int pair) {
+	cchar_t cc;
+
+	curs_setcc(cc,L' ',a,pair);
+	wbkgrnd((WINDOW*)win,&cc);
+}
+
+static inline int
+curs_ccpair(const cchar_t& cc) {
+#if defined(NCURSES_EXT_COLORS)
+	return cc.ext_color;
+#else
+	wchar_t wstr[CCHARW_MAX+1];
+	attr_t a;
+	short sp;
+	int pair = 0;
+
+	getcchar(&cc,wstr,&a,&sp,&pair);
+	return pair;
+#endif
+}
+
 static inline void
-curs_waddstr(void *win,const char *str) {
-	waddstr((WINDOW*)win,str);
+curs_setcell(cchar_t& cc,const Cell& cell) {
+	curs_setcc(cc,wchar_t(cell.ch),attr_t(cell.attrs),cell.pair);
+}
+
+static inline void
+curs_wadd_wchnstr(void *win,const cchar_t *cells,int n) {
+	wadd_wchnstr((WINDOW*)win,cells,n);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return the length of the leading run of printable ASCII (0x20 to
+// 0x7E) in str, testing 16 bytes at a time where SSE2 is available
+//////////////////////////////////////////////////////////////////////
+
+static inline size_t
+ascii_run(const char *str,size_t n) {
+	size_t x = 0;
+
+#if defined(__SSE2__)
+	const __m128i lo = _mm_set1_epi8(0x1F), hi = _mm_set1_epi8(0x7F);
+
+	for ( ; x + 16 <= n; x += 16 ) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(str + x));
+		__m128i ok = _mm_and_si128(_mm_cmpgt_epi8(v,lo),_mm_cmplt_epi8(v,hi));
+		unsigned mask = unsigned(_mm_movemask_epi8(ok));
+
+		if ( mask != 0xFFFF )
+			return x + __builtin_ctz(~mask);
+	}
+#endif
+	while ( x < n && uint8_t(str[x]) - 0x20u < 0x5Fu )
+		++x;
+	return x;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Add printable ASCII at the cursor. The cells are rendered as by
+// waddch() (window attributes and colour, merged with the background)
+// but written as runs with wadd_wchnstr(), with no decoding or width
+// lookup. The last column is left to waddch(), to wrap and scroll as
+// usual. When given, map supplies ACS glyphs (for addgrstr()).
+// Returns false if the text could not all be added (as waddstr()
+// stops at the bottom right corner, when not scrolling).
+//////////////////////////////////////////////////////////////////////
+
+static bool
+curs_waddascii(void *win,const char *str,size_t n,const chtype *map) {
+	WINDOW *w = (WINDOW*)win;
+	cchar_t buf[256], bk;
+	attr_t a;
+	short sp;
+	int pair = 0, y, x, maxx = getmaxx(w);
+
+	wattr_get(w,&a,&sp,&pair);
+	wgetbkgrnd(w,&bk);
+	if ( !pair )
+		pair = curs_ccpair(bk);
+	a = (a | bk.attr) & A_ATTRIBUTES & ~A_COLOR;
+
+	getyx(w,y,x);
+	while ( n > 0 ) {
+		size_t k = x < maxx - 1 ? size_t(maxx - 1 - x) : 0;
+
+		if ( k == 0 ) {
+			uint8_t ch = *str++;
+
+			if ( waddch(w,map && map[ch] ? map[ch] : ch) == ERR )
+				return false;
+			--n;
+			getyx(w,y,x);
+			continue;
+		}
+		if ( k > n )
+			k = n;
+		if ( k > 256 )
+			k = 256;
+
+		for ( size_t bx=0; bx < k; ++bx ) {
+			uint8_t ch = str[bx];
+			chtype c = map && map[ch] ? map[ch] : ch;
+
+			if ( c == ' ' ) {
+				buf[bx] = bk;		// Blanks take the background
+				curs_setcc(buf[bx],bk.chars[0],a,pair);
+				if ( bk.chars[0] != L' ' )
+					for ( int cx=1; cx < CCHARW_MAX; ++cx )
+						buf[bx].chars[cx] = bk.chars[cx];
+			} else	curs_setcc(buf[bx],wchar_t(c & A_CHARTEXT),a | (c & A_ATTRIBUTES),pair);
+		}
+		wadd_wchnstr(w,buf,int(k));
+		str += k;
+		n -= k;
+		x += k;
+		wmove(w,y,x);
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Add text that is not printable ASCII, up to the next printable
+// ASCII byte. The text is decoded per the locale (normally UTF-8),
+// invalid sequences and unprintable characters are replaced by
+// U+FFFD, and the result is added with waddnwstr(). Control
+// characters are passed on, for curses to act upon. Returns the
+// number of bytes consumed, or 0 at a NUL byte or when curses could
+// not add all of the text.
+//////////////////////////////////////////////////////////////////////
+
+static size_t
+curs_waddmb(void *win,const char *str,size_t n) {
+	WINDOW *w = (WINDOW*)win;
+	wchar_t buf[256];
+	mbstate_t mbs{};
+	size_t x = 0, nw = 0;
+
+	while ( x < n && uint8_t(str[x]) - 0x20u >= 0x5Fu ) {
+		wchar_t wc;
+		size_t len = mbrtowc(&wc,str+x,n-x,&mbs);
+
+		if ( len == 0 )
+			break;				// NUL ends the text
+		if ( len == size_t(-1) || len == size_t(-2) ) {
+			wc = 0xFFFD;
+			len = 1;
+			mbs = mbstate_t{};
+		} else if ( wc >= 0x20 && wcwidth(wc) < 0 )
+			wc = 0xFFFD;
+		buf[nw++] = wc;
+		x += len;
+		if ( nw == sizeof buf / sizeof buf[0] ) {
+			if ( waddnwstr(w,buf,int(nw)) == ERR )
+				return 0;
+			nw = 0;
+		}
+	}
+	if ( nw > 0 && waddnwstr(w,buf,int(nw)) == ERR )
+		return 0;
+	return x;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return the bytes of text that fit in cols columns, as addstr()
+// displays them (invalid and unprintable characters take a column),
+// and the columns they take in width
+//////////////////////////////////////////////////////////////////////
+
+size_t
+Window::clip_text(std::string_view text,int cols,int& width) {
+	mbstate_t mbs{};
+	size_t x = 0, len = text.size();
+
+	width = 0;
+	while ( x < len ) {
+		size_t n = 1;
+		int cw = 1;
+
+		if ( uint8_t(text[x]) >= 0x80 ) {
+			wchar_t wc;
+
+			n = mbrtowc(&wc,text.data()+x,len-x,&mbs);
+			if ( n == 0 || n == size_t(-1) || n == size_t(-2) ) {
+				n = 1;
+				mbs = mbstate_t{};
+			} else if ( (cw = wcwidth(wc)) < 0 )
+				cw = 1;
+		}
+		if ( width + cw > cols )
+			break;
+		width += cw;
+		x += n;
+	}
+	return x;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Add text of n bytes at the cursor (stopping at a NUL byte)
+//////////////////////////////////////////////////////////////////////
+
+static void
+curs_waddtext(void *win,const char *str,size_t n) {
+
+	while ( n > 0 ) {
+		size_t k = ascii_run(str,n);
+
+		if ( k > 0 ) {
+			if ( !curs_waddascii(win,str,k,nullptr) )
+				break;
+			str += k;
+			n -= k;
+		}
+		if ( n > 0 ) {
+			if ( (k = curs_waddmb(win,str,n)) == 0 )
+				break;
+			str += k;
+			n -= k;
+		}
+	}
 }
 
 static inline void
@@ -506,7 +1098,7 @@ curs_wattr_get(void *win,Window::wattr_t& attrs,Window::colpair_t& pair) {
 	short p = 0;
 
 	wattr_get((WINDOW*)win,&a,&p,nullptr);
-	attrs = Window::wattr_t(a);
+	attrs = Window::wattr_t(a & ~A_COLOR);	// Colour is in pair
 	pair = Window::colpair_t(p);
 }
 
@@ -544,21 +1136,44 @@ curs_getmaxyx(void *win,int& y,int& x) {
 #undef getparyx
 #undef getbegyx
 #undef getmaxyx
+#undef clrtoeol
+#undef scroll
+
+//////////////////////////////////////////////////////////////////////
+// Note that something was drawn, so that the next update composites
+// (and propagates changes made in the subwindow to this window)
+//////////////////////////////////////////////////////////////////////
+
+inline void
+Window::changed() {
+	dirtyf = true;
+	main->dirtyf = true;
+}
 
 Window::Window(CppCurses *main,void *win) : main(main), win(win) {
 
 	panel = new_panel((WINDOW*)win);
 	set_panel_userptr((PANEL*)panel,this);
 	mainf = true;	
+	main->zorder.assign(1,this);
 
 	cbreak();		// Disable line buffering
 	noecho();
 	keypad(stdscr,TRUE);	// Recognize keys
+
+	// Keys are read through a pad, because wgetch() on a window
+	// refreshes it if it was touched (bypassing the panels):
+	main->inwin = newpad(1,1);
+	keypad((WINDOW*)main->inwin,TRUE);
+	nodelay((WINDOW*)main->inwin,TRUE);	// getch() must not block: readch() waits
+
 	main->init_colours();
 	curs_wattr_get(win,attr,colour_pair);
 }
 
 Window::~Window() {
+	pair_cache.release(colour_pair);
+	pair_cache.release(border_pair);
 	if ( mainf ) {
 		main->fini();
 		mainf = false;
@@ -570,7 +1185,14 @@ Window::~Window() {
 		del_panel((PANEL*)panel);
 		delwin((WINDOW*)win);
 		win = nullptr;
-		this->do_update();
+		main->zorder.erase(std::find(main->zorder.begin(),main->zorder.end(),this));
+		if ( main->frame_stats.top == this )
+			main->frame_stats.top = nullptr;
+		if ( main->worst_stats.top == this )
+			main->worst_stats.top = nullptr;
+		changed();
+		if ( !main->framec )
+			this->do_update();
 	}
 }
 
@@ -579,78 +1201,177 @@ Window::addch(int ch) {
 	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
 
 	curs_waddch(w,ch);
+	changed();
 	return *this;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Add text, which may be UTF-8. Runs of printable ASCII take a fast
+// path; only the remaining text is decoded.
+//////////////////////////////////////////////////////////////////////
+
 Window&
 Window::addstr(const char *str) {
+	CPPCURSES_SPAN("Window::addstr");
 	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
 
-	curs_waddstr(w,str);
+	curs_waddtext(w,str,strlen(str));
+	changed();
 	return *this;
 }
 
 Window&
 Window::addstr(const std::string& str) {
+	CPPCURSES_SPAN("Window::addstr");
 	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
 
-	curs_waddstr(w,str.c_str());
+	curs_waddtext(w,str.data(),str.size());
+	changed();
 	return *this;
 }
 
 Window&
-Window::addgrstr(const char *str) {
+Window::addstr(std::string_view str) {
+	CPPCURSES_SPAN("Window::addstr");
 	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
-	char ch;
 
-	while ( (ch = *str++) != 0 ) {
-		auto it = graph_map.find(ch);
-		if ( it != graph_map.end() ) {
-			chtype c = it->second;
-			curs_waddch(w,c);
-		} else	curs_waddch(w,ch);
+	curs_waddtext(w,str.data(),str.size());
+	changed();
+	return *this;
+}
+
+Window&
+Window::addgrstr(const char *str) {
+	CPPCURSES_SPAN("Window::addgrstr");
+	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
+	size_t n = strlen(str);
+
+	while ( n > 0 ) {
+		size_t k = ascii_run(str,n);
+
+		if ( !curs_waddascii(w,str,k,graph_map.data()) )
+			break;
+		str += k;
+		n -= k;
+		if ( n > 0 ) {
+			curs_waddch(w,uint8_t(*str++));
+			--n;
+		}
 	}
+	changed();
 	return *this;
 }
 
+//////////////////////////////////////////////////////////////////////
+// printf() formatting, into a stack buffer when the text fits
+//////////////////////////////////////////////////////////////////////
+
+static size_t
+curs_vwprintf(void *win,const char *format,va_list ap) {
+	char buf[512];
+	va_list ap2;
+	int n;
+
+	va_copy(ap2,ap);
+	n = vsnprintf(buf,sizeof buf,format,ap2);
+	va_end(ap2);
+	if ( n < 0 )
+		return 0;
+	if ( size_t(n) < sizeof buf ) {
+		curs_waddtext(win,buf,n);
+	} else	{
+		std::vector<char> text(n+1);
+
+		vsnprintf(text.data(),text.size(),format,ap);
+		curs_waddtext(win,text.data(),n);
+	}
+	return n;
+}
+
 size_t
 Window::printf(const char *format,...) {
+	CPPCURSES_SPAN("Window::printf");
 	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
 	va_list ap;
 	size_t n;
 
 	va_start(ap,format);
-	n = vwprintw(w,format,ap);
+	n = curs_vwprintf(w,format,ap);
 	va_end(ap);
+	changed();
 	return n;
 }
 
 size_t
 Window::mvprintf(int y,int x,const char *format,...) {
+	CPPCURSES_SPAN("Window::mvprintf");
 	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
 	va_list ap;
 	size_t n;
 
 	wmove(w,y,x);
 	va_start(ap,format);
-	n = vwprintw(w,format,ap);
+	n = curs_vwprintf(w,format,ap);
 	va_end(ap);
+	changed();
 	return n;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Type safe formatting: the text is formatted into a stack buffer
+// and added as by addstr(). The print() and
+// mvprint() templates check the format string at compile time.
+//////////////////////////////////////////////////////////////////////
+
+size_t
+Window::vprint(std::string_view format,const FormatArg *args,size_t nargs) {
+	CPPCURSES_SPAN("Window::vprint");
+	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
+	FormatBuffer buf;
+
+	format_to(buf,format,args,nargs);
+	curs_waddtext(w,buf.data(),buf.size());
+	changed();
+	return buf.size();
+}
+
+size_t
+Window::mvvprint(int y,int x,std::string_view format,const FormatArg *args,size_t nargs) {
+	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
+
+	wmove(w,y,x);
+	return vprint(format,args,nargs);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Composite all panels to the terminal. Inside of a begin_frame()
+// and end_frame() pair, this is deferred until end_frame(). With a
+// frame rate cap (CppCurses::max_fps()), it is deferred to the next
+// frame, and requests until then share one update.
+//////////////////////////////////////////////////////////////////////
+
 Window&
 Window::refresh() {
-	PANEL *p = panel_above(nullptr);	// Bottom panel is returned
+	CPPCURSES_SPAN("Window::refresh");
 
-	while ( p ) {
-		Window *w = (Window*)panel_userptr(p);
-		w->wposition();
-		p = panel_above(p);		// Next panel up
+	++main->statistics.requests;
+	if ( main->framec > 0 ) {
+		main->dirtyf = true;
+		return *this;
+	}
+	if ( !main->frame_due() ) {
+		main->dirtyf = main->pendingf = true;
+		return *this;
 	}
+	this->composite();
+	return *this;
+}
+
+void
+Window::composite() {
 
 	assert(win);
 	this->do_update();
-	return *this;
 }
 
 Window&
@@ -658,103 +1379,285 @@ Window::move(int y,int x) {
 	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
 
 	wmove(w,y,x);
+	changed();
 	return *this;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Write a row of prebuilt cells at { y,x }, one curses call per up to
+// 256 cells. The cells are clipped at the right edge and the cursor
+// is left at { y,x }. The window's current attributes are not used.
+//////////////////////////////////////////////////////////////////////
+
 Window&
-Window::bgclear() {
+Window::blit(short y,short x,std::span<const Cell> cells) {
+	CPPCURSES_SPAN("Window::blit");
 	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
+	cchar_t buf[256];
+	int ncols = getmaxx(w);
+
+	if ( x < 0 || x >= ncols || y < 0 || y >= getmaxy(w) )
+		return *this;
+	if ( cells.size() > size_t(ncols - x) )
+		cells = cells.first(ncols - x);
 
-	wbkgd((WINDOW*)w,attr_t(this->attr));
+	for ( size_t cx=0; cx < cells.size(); cx += 256 ) {
+		size_t n = cells.size() - cx < 256 ? cells.size() - cx : 256;
+
+		for ( size_t bx=0; bx < n; ++bx )
+			curs_setcell(buf[bx],cells[cx+bx]);
+		wmove(w,y,x+cx);
+		curs_wadd_wchnstr(w,buf,int(n));
+	}
+	wmove(w,y,x);
+	changed();
 	return *this;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Write nlines rows of ncols cells, stored row after row in cells
+//////////////////////////////////////////////////////////////////////
+
 Window&
-Window::erase() {
-	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
+Window::blit_rect(short y,short x,short nlines,short ncols,std::span<const Cell> cells) {
 
-	werase(w);
+	assert(nlines >= 0 && ncols >= 0);
+	assert(cells.size() >= size_t(nlines) * size_t(ncols));
+
+	for ( short ry=0; ry < nlines; ++ry )
+		blit(y+ry,x,cells.subspan(size_t(ry) * ncols,ncols));
 	return *this;
 }
 
 Window&
-Window::clear() {
+Window::bgclear() {
 	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
 
-	wclear(w);
+	curs_wbkgd(w,attr_t(this->attr),colour_pair);
+	changed();
 	return *this;
 }
 
 Window&
-Window::attr_on(const char *attrs) {
+Window::erase() {
+	CPPCURSES_SPAN("Window::erase");
 	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
-	attr = wattr_t(to_attrs(attrs));
 
-	curs_wattr_on(w,attr_t(attr));
-	curs_wattr_get(win,attr,colour_pair);
+	werase(w);
+	changed();
 	return *this;
 }
 
 Window&
-Window::attr_off(const char *attrs) {
+Window::clear() {
+	CPPCURSES_SPAN("Window::clear");
 	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
-	attr = wattr_t(to_attrs(attrs));
 
-	curs_wattr_off(w,attr_t(attr));
-	curs_wattr_get(win,attr,colour_pair);
+	wclear(w);
+	changed();
+	return *this;
+}
+
+Window&
+Window::clrtoeol() {
+	CPPCURSES_SPAN("Window::clrtoeol");
+	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
+
+	wclrtoeol(w);
+	changed();
+	return *this;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Scroll lines top..bottom (bottom < 0 is the last line) up n lines
+// (down if n < 0), leaving blank lines at the bottom (top). With
+// idlok(), the update can then scroll the terminal's region, rather
+// than repaint the moved lines.
+//////////////////////////////////////////////////////////////////////
+
+Window&
+Window::scroll(int n,short top,short bottom) {
+	CPPCURSES_SPAN("Window::scroll");
+	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
+	int maxy = getmaxy(w);
+
+	if ( bottom < 0 || bottom >= maxy )
+		bottom = maxy - 1;
+	if ( top < 0 || top > bottom )
+		return *this;
+
+	idlok(w,TRUE);
+	scrollok(w,TRUE);
+	wsetscrreg(w,top,bottom);
+	wscrl(w,n);
+	wsetscrreg(w,0,maxy-1);
+	scrollok(w,FALSE);			// Text at the bottom right must not scroll
+	changed();
 	return *this;
 }
 
+Window&
+Window::attr_on(const char *attrs) {
+	return attr_on(Attrs(to_attrs(attrs)));
+}
+
+Window&
+Window::attr_off(const char *attrs) {
+	return attr_off(Attrs(to_attrs(attrs)));
+}
+
 Window&
 Window::attr_set(const char *attrs,colpair_t pair) {
+	return attr_set(Attrs(to_attrs(attrs)),pair);
+}
+
+//////////////////////////////////////////////////////////////////////
+// The attributes and colour pair of the window are tracked in attr
+// and colour_pair, so no round trip through wattr_get() is needed.
+//////////////////////////////////////////////////////////////////////
+
+Window&
+Window::attr_on(Attrs attrs) {
+	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
+
+	attr |= attrs.bits;
+	curs_wattr_on(w,attr_t(attrs.bits));
+	return *this;
+}
+
+Window&
+Window::attr_off(Attrs attrs) {
+	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
+
+	attr &= ~attrs.bits;
+	curs_wattr_off(w,attr_t(attrs.bits));
+	return *this;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Change the window's colour pair, holding a cached pair (so that it
+// is not recycled while in use)
+//////////////////////////////////////////////////////////////////////
+
+void
+Window::set_pair(colpair_t pair) {
+
+	if ( pair != colour_pair ) {
+		pair_cache.hold(pair);
+		pair_cache.release(colour_pair);
+		colour_pair = pair;
+	}
+}
+
+Window&
+Window::attr_set(Attrs attrs,colpair_t pair) {
 	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
-	attr = wattr_t(to_attrs(attrs));
 
+	attr = attrs.bits;
+	set_pair(pair);
 	curs_wattr_set(w,attr_t(attr),pair);
-	curs_wattr_get(win,attr,colour_pair);
 	return *this;
 }
 
+Window&
+Window::style(const Style& style) {
+	return attr_set(style.attrs,style.pair);
+}
+
 Window&
 Window::colour(Colour fg,Colour bg) {
 	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
-	colour_pair = Window::to_colour(fg,bg);
 
-	curs_wattron(w,colour_pair);
-	curs_wattr_get(w,attr,colour_pair);
+	set_pair(Window::to_colour(fg,bg));
+	curs_wcolor_set(w,colour_pair);
+	return *this;
+}
+
+Window&
+Window::colour(int fg,int bg) {
+	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
+
+	set_pair(curs_pair(curs_index(fg),curs_index(bg),main->statistics));
+	curs_wcolor_set(w,colour_pair);
+	return *this;
+}
+
+Window&
+Window::colour(Rgb fg,Rgb bg) {
+	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
+
+	set_pair(curs_pair(curs_rgb(fg),curs_rgb(bg),main->statistics));
+	curs_wcolor_set(w,colour_pair);
 	return *this;
 }
 
 Window&
 Window::fg(Colour fg) {
 	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
-	Colour bg(Colour(curs_background(colour_pair)));;
-	colpair_t colour_pair = Window::to_colour(fg,bg);
+	int fgno, bgno;
 
-	curs_wattron(w,colour_pair);
-	curs_wattr_get(w,attr,colour_pair);
+	if ( colour_pair < 64 ) {
+		Colour bg(Colour(curs_background(colour_pair)));
+		set_pair(Window::to_colour(fg,bg));
+	} else	{
+		curs_pair_colours(colour_pair,fgno,bgno);
+		set_pair(curs_pair(colour_map[int(fg)],bgno,main->statistics));
+	}
+	curs_wcolor_set(w,colour_pair);
 	return *this;
 }
 
 Window&
 Window::bg(Colour bg) {
 	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
-	Colour fg(Colour(curs_foreground(colour_pair)));;
-	colour_pair = Window::to_colour(fg,bg);
+	int fgno, bgno;
 
-	curs_wattron(w,colour_pair);
-	curs_wattr_get(w,attr,colour_pair);
+	if ( colour_pair < 64 ) {
+		Colour fg(Colour(curs_foreground(colour_pair)));
+		set_pair(Window::to_colour(fg,bg));
+	} else	{
+		curs_pair_colours(colour_pair,fgno,bgno);
+		set_pair(curs_pair(fgno,colour_map[int(bg)],main->statistics));
+	}
+	curs_wcolor_set(w,colour_pair);
 	return *this;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Return the colour pair for { fg,bg }, for use in a Cell or Style,
+// without changing the window's colours. A cached pair is not held:
+// it is valid until the cache recycles it (see PairCache), so look
+// it up again when drawing.
+//////////////////////////////////////////////////////////////////////
+
+Window::colpair_t
+Window::pair(Colour fg,Colour bg) {
+	return to_colour(fg,bg);
+}
+
+Window::colpair_t
+Window::pair(int fg,int bg) {
+	return curs_pair(curs_index(fg),curs_index(bg),main->statistics);
+}
+
+Window::colpair_t
+Window::pair(Rgb fg,Rgb bg) {
+	return curs_pair(curs_rgb(fg),curs_rgb(bg),main->statistics);
+}
+
+int
+Window::colours() {
+	return COLORS;
+}
+
 Window *
 Window::new_window(short y,short x,short nlines,short ncols) {
 	Window *w = new Window(this,y,x,nlines,ncols);
 
 	w->attr = this->attr;
-	w->colour_pair = this->colour_pair;
+	w->set_pair(this->colour_pair);
 	curs_wattr_set(w->win,w->attr,w->colour_pair);
-	wbkgd((WINDOW*)w->win,w->attr);
+	curs_wbkgd(w->win,w->attr,w->colour_pair);
 	curs_leaveok(w->win,false);
 	curs_move(w->win,0,0);
 	return w;
@@ -765,10 +1668,15 @@ Window::subwindow(short y,short x,short nlines,short ncols) {
 	if ( sub )
 		delwin((WINDOW*)sub);
 	sub = derwin((WINDOW*)win,nlines,ncols,y,x);
+	sub_y = y;
+	sub_x = x;
+	sub_lines = nlines;
+	sub_cols = ncols;
 	curs_wattr_set(sub,attr,colour_pair);
-	wbkgd((WINDOW*)sub,attr);
+	curs_wbkgd(sub,attr,colour_pair);
 	curs_leaveok(sub,false);
 	curs_move(sub,0,0);
+	changed();
 	return *this;
 }
 
@@ -776,36 +1684,18 @@ Window *
 Window::border_window(short y,short x,short nlines,short ncols) {
 	Window *w = new Window(this,y,x,nlines,ncols);
 
+	if ( nlines <= 0 )
+		nlines = LINES - y;
+	if ( ncols <= 0 )
+		ncols = COLS - x;
 	if ( nlines > 2 && ncols > 2 ) {
-		WINDOW *nw = (WINDOW*)w->win;
-
-		curs_wmove(nw,0,0);
-
 		w->attr = this->attr;
-		w->colour_pair = this->colour_pair;
-		curs_wattr_set(nw,w->attr,w->colour_pair);
-		wbkgd((WINDOW*)nw,w->attr);
-
-		curs_waddch(nw,ACS_ULCORNER);
-		for ( short tx=1; tx<ncols-1; ++tx )
-			curs_waddch(nw,ACS_HLINE);
-		curs_waddch(nw,ACS_URCORNER);
-
-		curs_wmove(nw,nlines-1,0);
-		curs_waddch(nw,ACS_LLCORNER);
-		for ( short tx=1; tx<ncols-1; ++tx )
-			curs_waddch(nw,ACS_HLINE);
-		curs_waddch(nw,ACS_LRCORNER);
-
-		for ( short ty=1; ty<nlines-1; ++ty ) {
-			curs_wmove(nw,ty,0);
-			curs_waddch(nw,ACS_VLINE);
-			curs_wmove(nw,ty,ncols-1);
-			curs_waddch(nw,ACS_VLINE);
-		}
-
-		touchwin((WINDOW*)nw);
-		w->sub = derwin(nw,nlines-2,ncols-2,1,1);
+		w->set_pair(this->colour_pair);
+		curs_wbkgd(w->win,w->attr,w->colour_pair);
+		w->restyle(Border::Single,w->attr,w->colour_pair);
+		w->frame();
+		w->sub = derwin((WINDOW*)w->win,nlines-2,ncols-2,1,1);
+		w->borderf = true;
 		curs_wattr_set(w->sub,w->attr,w->colour_pair);
 		curs_leaveok(w->sub,false);
 		curs_move(w->sub,0,0);
@@ -813,60 +1703,568 @@ Window::border_window(short y,short x,short nlines,short ncols) {
 	return w;
 }
 
-Window::Window(Window *parent,short y,short x,short nlines,short ncols) : main(parent->main) {
+//////////////////////////////////////////////////////////////////////
+// The eight cells of a frame, in wborder_set() order: left, right,
+// top and bottom sides, then the corners (upper left, upper right,
+// lower left and lower right)
+//////////////////////////////////////////////////////////////////////
+
+static void
+curs_frame_cells(Border kind,attr_t a,int pair,cchar_t cells[8]) {
+	static const wchar_t ascii[8] = { '|', '|', '-', '-', '+', '+', '+', '+' };
+	static const wchar_t rounded[4] = { 0x256D, 0x256E, 0x2570, 0x256F };	// ╭ ╮ ╰ ╯
+
+	if ( kind == Border::Ascii ) {
+		for ( unsigned x=0; x<8; ++x )
+			curs_setcc(cells[x],ascii[x],a,pair);
+		return;
+	}
+
+	const cchar_t *wacs[8];
+
+	switch ( kind ) {
+	case Border::Double:
+		wacs[0] = wacs[1] = WACS_D_VLINE;
+		wacs[2] = wacs[3] = WACS_D_HLINE;
+		wacs[4] = WACS_D_ULCORNER;
+		wacs[5] = WACS_D_URCORNER;
+		wacs[6] = WACS_D_LLCORNER;
+		wacs[7] = WACS_D_LRCORNER;
+		break;
+	case Border::Heavy:
+		wacs[0] = wacs[1] = WACS_T_VLINE;
+		wacs[2] = wacs[3] = WACS_T_HLINE;
+		wacs[4] = WACS_T_ULCORNER;
+		wacs[5] = WACS_T_URCORNER;
+		wacs[6] = WACS_T_LLCORNER;
+		wacs[7] = WACS_T_LRCORNER;
+		break;
+	default:
+		wacs[0] = wacs[1] = WACS_VLINE;
+		wacs[2] = wacs[3] = WACS_HLINE;
+		wacs[4] = WACS_ULCORNER;
+		wacs[5] = WACS_URCORNER;
+		wacs[6] = WACS_LLCORNER;
+		wacs[7] = WACS_LRCORNER;
+	}
+
+	for ( unsigned x=0; x<8; ++x ) {
+		wchar_t wstr[CCHARW_MAX+1];
+		attr_t wa;
+		short sp;
+
+		getcchar(wacs[x],wstr,&wa,&sp,nullptr);	// Unicode, or the ACS character
+		if ( kind == Border::Rounded && x >= 4 && MB_CUR_MAX > 1 ) {
+			wstr[0] = rounded[x-4];
+			wa = 0;
+		}
+		curs_setcc(cells[x],wstr[0],wa | a,pair);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Draw the frame of a border_window() with one wborder_set(), and
+// its title from column 2. The frame is retained: it is only drawn
+// again when the window's size, or the frame's style or title, was
+// changed (the window's content is in the subwindow, so drawing and
+// updates never touch it).
+//////////////////////////////////////////////////////////////////////
+
+void
+Window::frame() {
+	WINDOW *nw = (WINDOW*)win;
+	int nlines, ncols;
+	cchar_t cells[8];
+
+	curs_getmaxyx(nw,nlines,ncols);
+	if ( framedf && nlines == framed_lines && ncols == framed_cols )
+		return;
+
+	curs_frame_cells(border_kind,border_attr,border_pair,cells);
+	wborder_set(nw,&cells[0],&cells[1],&cells[2],&cells[3],&cells[4],&cells[5],&cells[6],&cells[7]);
+	if ( !border_text.empty() && ncols > 4 ) {
+		int width;
+		size_t n = clip_text(border_text,ncols - 4,width);
+
+		curs_wattr_set(nw,border_attr,border_pair);
+		curs_wmove(nw,0,2);
+		curs_waddtext(nw,border_text.data(),n);
+		curs_wattr_set(nw,attr,colour_pair);
+	}
+
+	framedf = true;
+	framed_lines = short(nlines);
+	framed_cols = short(ncols);
+	++main->statistics.borders_drawn;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Change the frame's style: drawn at the next frame() if it differs
+//////////////////////////////////////////////////////////////////////
+
+void
+Window::restyle(Border kind,wattr_t attrs,colpair_t pair) {
+
+	if ( kind != border_kind || attrs != border_attr || pair != border_pair ) {
+		pair_cache.hold(pair);
+		pair_cache.release(border_pair);
+		border_kind = kind;
+		border_attr = attrs;
+		border_pair = pair;
+		framedf = false;
+	}
+}
+
+Window&
+Window::border_style(Border kind) {
+
+	if ( borderf ) {
+		restyle(kind,border_attr,border_pair);
+		frame();
+		changed();
+	}
+	return *this;
+}
+
+Window&
+Window::border_style(const Style& style) {
+
+	if ( borderf ) {
+		restyle(border_kind,style.attrs.bits,style.pair);
+		frame();
+		changed();
+	}
+	return *this;
+}
+
+Window&
+Window::border_title(std::string_view title) {
+
+	if ( borderf && title != border_text ) {
+		border_text.assign(title.data(),title.size());
+		framedf = false;		// The old title is drawn over
+		frame();
+		changed();
+	}
+	return *this;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Blank the border, before the window is resized
+//////////////////////////////////////////////////////////////////////
+
+void
+Window::unframe() {
+	wborder((WINDOW*)win,' ',' ',' ',' ',' ',' ',' ',' ');
+	framedf = false;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Windows made through a WindowHandle are pooled: a window of the
+// same size and kind is taken from the retired windows, if there is
+// one, and made to look new. This saves the allocation of the curses
+// WINDOW and PANEL (and of the subwindow of a border window).
+//////////////////////////////////////////////////////////////////////
+
+Window *
+Window::recycle(short y,short x,short nlines,short ncols,bool border) {
+	short lines = nlines, cols = ncols;
+	Window *w;
+
+	if ( nlines <= 0 )
+		nlines = LINES - y;
+	if ( ncols <= 0 )
+		ncols = COLS - x;
+	if ( border && (nlines <= 2 || ncols <= 2) )
+		border = false;			// border_window() makes no border
+	if ( !(w = main->reuse(nlines,ncols,border)) )
+		return nullptr;
+
+	if ( border && (w->attr != this->attr || w->colour_pair != this->colour_pair) )
+		curs_wbkgd(w->win,this->attr,this->colour_pair);
+	w->attr = this->attr;
+	w->set_pair(this->colour_pair);
+	w->lay_y = y;
+	w->lay_x = x;
+	w->lay_lines = lines;
+	w->lay_cols = cols;
+	w->resize_fn = nullptr;
+	w->resize_arg = nullptr;
+	move_panel((PANEL*)w->panel,y,x);
+	if ( border ) {
+		w->restyle(Border::Single,w->attr,w->colour_pair);
+		if ( !w->border_text.empty() ) {
+			w->border_text.clear();
+			w->framedf = false;
+		}
+		w->frame();			// Only if it differs
+		curs_wbkgd(w->sub,w->attr,w->colour_pair);
+	} else	curs_wbkgd(w->win,w->attr,w->colour_pair);
+	curs_wattr_set(border ? w->sub : w->win,w->attr,w->colour_pair);
+	werase(border ? (WINDOW*)w->sub : (WINDOW*)w->win);
+	curs_leaveok(border ? w->sub : w->win,false);
+	curs_move(border ? w->sub : w->win,0,0);
+	w->show();				// On top
+	++main->statistics.window_reuses;
+	return w;
+}
+
+WindowHandle
+Window::make_window(short y,short x,short nlines,short ncols) {
+	Window *w = recycle(y,x,nlines,ncols,false);
+
+	return WindowHandle(w ? w : new_window(y,x,nlines,ncols));
+}
+
+WindowHandle
+Window::make_border_window(short y,short x,short nlines,short ncols) {
+	Window *w = recycle(y,x,nlines,ncols,true);
+
+	return WindowHandle(w ? w : border_window(y,x,nlines,ncols));
+}
+
+void
+WindowHandle::reset() {
+
+	if ( w ) {
+		Window *p = w;
+
+		w = nullptr;
+		p->main->retire(p);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Window objects come from slabs, and are recycled through a free
+// list (curses is single threaded, so no locking is needed). Classes
+// derived from Window, of a different size, use the heap.
+//////////////////////////////////////////////////////////////////////
+
+union WindowSlot {
+	WindowSlot	*next;
+	alignas(Window) char storage[sizeof(Window)];
+};
+
+static WindowSlot *free_slots = nullptr;
+static const unsigned slab_windows = 32;
+
+void *
+Window::operator new(size_t size) {
+	WindowSlot *slot;
+
+	if ( size != sizeof(Window) )
+		return ::operator new(size);
+	if ( !free_slots ) {
+		WindowSlot *slab = (WindowSlot*)::operator new(sizeof(WindowSlot) * slab_windows);
+
+		for ( unsigned x=0; x<slab_windows; ++x ) {
+			slab[x].next = free_slots;
+			free_slots = &slab[x];
+		}
+	}
+	slot = free_slots;
+	free_slots = slot->next;
+	return slot;
+}
+
+void
+Window::operator delete(void *p,size_t size) {
+
+	if ( size != sizeof(Window) ) {
+		::operator delete(p);
+		return;
+	}
+	WindowSlot *slot = (WindowSlot*)p;
+
+	slot->next = free_slots;
+	free_slots = slot;
+}
+
+Window::Window(Window *parent,short y,short x,short nlines,short ncols)
+	: main(parent->main), lay_y(y), lay_x(x), lay_lines(nlines), lay_cols(ncols) {
 
 	win = newwin(nlines,ncols,y,x);
 	panel = new_panel((WINDOW *)win);
 	set_panel_userptr((PANEL*)panel,this);
 	top_panel((PANEL*)panel);
+	main->zorder.push_back(this);
 	this->erase();
 }
 
+//////////////////////////////////////////////////////////////////////
+// Update the screen, in one pass over the visible windows (from the
+// z-order list, rather than through libpanel). Drawing into a derwin()
+// subwindow does not mark the panel's window as changed, so the
+// changes of dirty subwindows are propagated with wsyncup() (only the
+// changed cells are touched), and the window's cursor is placed where
+// the subwindow's is. Windows that were not drawn into are left alone.
+// The terminal is then written by doupdate(), or by the library's own
+// ScreenDiff (CppCurses::diff_render()).
+//////////////////////////////////////////////////////////////////////
+
 void
 Window::do_update() {
-	PANEL *p = panel_above(nullptr);	// Start with bottom panel
-
-	while ( p ) {
-		Window *w = (Window*)panel_userptr(p);
+	CPPCURSES_SPAN("Window::do_update");
+
+	if ( main->resizef )
+		main->relayout();		// Deferred to this frame
+	main->dirtyf = main->pendingf = false;
+	if ( main->frame_ns > 0 )
+		main->last_frame = CppCurses::now_ns();
+	++main->statistics.updates;
+
+	CppCurses::FrameStats synced;
+
+	for ( Window *w : main->zorder ) {
+		if ( !w->dirtyf || w->hiddenf )
+			continue;
+		if ( main->accountf ) {
+			unsigned long cells = w->account_sync();
+
+			synced.cells += cells;
+			if ( cells > synced.top_cells ) {
+				synced.top = w;		// Drew the most
+				synced.top_cells = cells;
+			}
+		}
 		if ( w->sub ) {
-			touchwin((WINDOW*)w->win);
+			w->wposition();
+			wsyncup((WINDOW*)w->sub);
+			untouchwin((WINDOW*)w->sub);
 		}
-		p = panel_above((PANEL*)w->panel);
+		w->dirtyf = false;
+		++synced.windows;
 	}
-	update_panels();
-	doupdate();
+	{
+		CPPCURSES_SPAN("update_panels");
+		update_panels();
+	}
+
+	CPPCURSES_SPAN("doupdate");
+	CppCurses::FrameStats mark;
+
+	if ( main->accountf )
+		main->output_begin(mark);
+	if ( main->differ )
+		main->differ->update();
+	else	main->write_frame();
+	if ( main->accountf )
+		main->output_end(mark,synced);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Output accounting: count the cells of the rows changed in a window
+// being synced (its subwindow's, if it has one)
+//////////////////////////////////////////////////////////////////////
+
+unsigned long
+Window::account_sync() {
+	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
+	int nlines = getmaxy(w), ncols = getmaxx(w);
+	unsigned long cells = 0;
+
+	for ( int y=0; y<nlines; ++y )
+		if ( is_linetouched(w,y) )
+			cells += ncols;
+	synced_cells += cells;
+	return cells;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Keep the z-order list in step with the panel stack: raise to the
+// top (first == false) or lower to the bottom
+//////////////////////////////////////////////////////////////////////
+
+void
+Window::restack(bool first) {
+	std::vector<Window*>& z = main->zorder;
+	auto it = std::find(z.begin(),z.end(),this);
+
+	assert(it != z.end());
+	if ( first )
+		std::rotate(z.begin(),it,it+1);
+	else	std::rotate(it,it+1,z.end());
 }
 
 Window&
 Window::hide() {
 	hide_panel((PANEL*)panel);
+	hiddenf = true;
+	changed();
 	return *this;
 }
 
 Window&
 Window::show() {
+	show_panel((PANEL*)panel);	// Also raises it
+	hiddenf = false;
+	restack(false);
+	changed();
+	return *this;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Show a hidden window at its place in the stack: show_panel() puts
+// it on top, so the visible windows that were above it are raised
+// again, in order.
+//////////////////////////////////////////////////////////////////////
+
+Window&
+Window::unhide() {
+	std::vector<Window*>& z = main->zorder;
+	auto it = std::find(z.begin(),z.end(),this);
+
+	assert(it != z.end());
 	show_panel((PANEL*)panel);
+	hiddenf = false;
+	while ( ++it != z.end() )
+		if ( !(*it)->hiddenf )
+			top_panel((PANEL*)(*it)->panel);
+	changed();
 	return *this;
 }
 
 Window&
 Window::top() {
 	top_panel((PANEL*)panel);
+	hiddenf = false;
+	restack(false);
+	changed();
 	return *this;
 }
 
 Window&
 Window::bottom() {
 	bottom_panel((PANEL*)panel);
+	hiddenf = false;
+	restack(true);
+	changed();
 	return *this;
 }
 
 Window&
 Window::move_window(short starty,short startx) {
 	move_panel((PANEL*)panel,starty,startx);
+	lay_y = starty;
+	lay_x = startx;
+	changed();
+	return *this;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Resize the window in place: its content, subwindow and place in
+// the stack are kept (a border is redrawn). Only what it uncovered
+// and its own area are redrawn. A size of 0 reaches to the edge of
+// the screen, and follows it when the terminal is resized.
+//////////////////////////////////////////////////////////////////////
+
+Window&
+Window::resize(short nlines,short ncols) {
+	int y, x;
+
+	if ( mainf )
+		return *this;			// Sized by the terminal
+	curs_getbegyx(win,y,x);
+	lay_lines = nlines;
+	lay_cols = ncols;
+	reshape(y,x,nlines,ncols);
 	return *this;
 }
 
+Window&
+Window::place(short y,short x,short nlines,short ncols) {
+
+	if ( mainf )
+		return *this;
+	lay_y = y;
+	lay_x = x;
+	lay_lines = nlines;
+	lay_cols = ncols;
+	reshape(y,x,nlines,ncols);
+	return *this;
+}
+
+//////////////////////////////////////////////////////////////////////
+// When the terminal is resized, a window is given the geometry it
+// was made with (or last moved or resized to), with a 0 size reaching
+// to the new edge, and moved or shrunk as needed to stay on screen.
+// With a function, func(arg,window,rows,cols) is called instead, to
+// move_window() and resize() it and redraw its content. It must not
+// create or delete windows.
+//////////////////////////////////////////////////////////////////////
+
+Window&
+Window::on_resize(ResizeFunc func,void *arg) {
+	resize_fn = func;
+	resize_arg = arg;
+	return *this;
+}
+
+void
+Window::relayout(short rows,short cols) {
+
+	if ( resize_fn )
+		resize_fn(resize_arg,*this,rows,cols);
+	else if ( !mainf )
+		reshape(lay_y,lay_x,lay_lines,lay_cols);
+	if ( borderf )
+		frame();
+	touchwin((WINDOW*)win);		// resize_term() may have grown it
+}
+
+//////////////////////////////////////////////////////////////////////
+// Give the window a new geometry, fitted to the screen: wresize() and
+// mvwin() it, then fit the subwindow (with wresize() and mvderwin(),
+// which keep it sharing the window's cells). The area it uncovers is
+// touched here, rather than by move_panel(), which would touch every
+// panel below for a move (costly when a layout places hundreds).
+//////////////////////////////////////////////////////////////////////
+
+void
+Window::reshape(short y,short x,short nlines,short ncols) {
+	int min = borderf ? 3 : 1;
+	int oy, ox, olines, ocols;
+
+	if ( LINES < min || COLS < min )
+		return;
+	if ( nlines <= 0 )
+		nlines = LINES - y;
+	if ( ncols <= 0 )
+		ncols = COLS - x;
+	nlines = std::clamp<int>(nlines,min,LINES);
+	ncols = std::clamp<int>(ncols,min,COLS);
+	y = std::clamp<int>(y,0,LINES - nlines);
+	x = std::clamp<int>(x,0,COLS - ncols);
+
+	curs_getbegyx(win,oy,ox);
+	curs_getmaxyx(win,olines,ocols);
+	if ( y == oy && x == ox && nlines == olines && ncols == ocols )
+		return;
+
+	if ( !hiddenf && (oy < y || ox < x || oy + olines > y + nlines || ox + ocols > x + ncols) )
+		main->expose(oy,ox,olines,ocols,this);	// Part is uncovered
+	if ( borderf )
+		unframe();
+	wresize((WINDOW*)win,nlines,ncols);
+	mvwin((WINDOW*)win,y,x);		// The old area was exposed above
+
+	if ( borderf ) {
+		wresize((WINDOW*)sub,nlines - 2,ncols - 2);
+		frame();
+	} else if ( sub ) {
+		int sy = std::min<int>(sub_y,nlines - 1);
+		int sx = std::min<int>(sub_x,ncols - 1);
+		int sl = sub_lines > 0 ? std::min<int>(sub_lines,nlines - sy) : nlines - sy;
+		int sc = sub_cols > 0 ? std::min<int>(sub_cols,ncols - sx) : ncols - sx;
+
+		wresize((WINDOW*)sub,1,1);	// So that it can move anywhere
+		mvderwin((WINDOW*)sub,sy,sx);
+		wresize((WINDOW*)sub,sl,sc);
+	}
+	touchwin((WINDOW*)win);
+	changed();
+}
+
 Window&
 Window::get_yx(int& y,int& x) {
 	curs_getyx((WINDOW*)win,y,x);
@@ -901,27 +2299,74 @@ Window::size(int& y,int& x) {
 	return *this;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Read a key without blocking (-1 if none). The screen is only
+// updated first, if something was drawn since the last update (and
+// with a frame rate cap, only once the frame is due).
+//////////////////////////////////////////////////////////////////////
+
 int
 Window::getch() {
+	CPPCURSES_SPAN("Window::getch");
 	int ch;
 
-	this->refresh();
-	ch = curs_getch();
+	if ( main->pendingf )
+		main->poll_refresh();
+	else if ( main->dirtyf )
+		this->refresh();
+	ch = curs_getch(main->inwin);
 	if ( ch == ERR )
 		return -1;
 	return ch;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Block until a key is read. The argument was the interval at which
+// the input was polled: the wait is now done in the kernel, so it is
+// unused.
+//////////////////////////////////////////////////////////////////////
+
+int
+Window::readch(unsigned) {
+	return readch_for(-1);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Block until a key is read, or ms milliseconds elapse (returns -1).
+// Waiting is done in the kernel (epoll), so there are no wakeups
+// while idle. A ms value < 0 waits indefinitely. Like getch(), the
+// screen is only updated when something was drawn.
+//////////////////////////////////////////////////////////////////////
+
 int
-Window::readch(unsigned ms) {
+Window::readch_for(int ms) {
+	CPPCURSES_SPAN("Window::readch");
+	timespec deadline;
 	int ch;
 
-	this->refresh();
-	while ( (ch = curs_getch()) == -1 )
-		usleep(ms);
+	if ( main->pendingf )
+		main->poll_refresh();
+	else if ( main->dirtyf )
+		this->refresh();
+	if ( ms >= 0 )
+		CppCurses::to_deadline(ms,deadline);
+
+	while ( (ch = curs_getch(main->inwin)) == ERR ) {
+		if ( main->wait_until(ms >= 0 ? &deadline : nullptr) == Event::Timeout )
+			return -1;
+	}
 	return ch;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Wait for input, a terminal resize or timeout without reading
+//////////////////////////////////////////////////////////////////////
+
+Event
+Window::wait_event(int ms) {
+	return main->wait_event(ms);
+}
+
 Window&
 Window::yield() {
 	::sched_yield();
@@ -945,14 +2390,35 @@ Window::cursor(bool on) {
 	WINDOW *w = sub ? (WINDOW*)sub : (WINDOW*)win;
 
 	curs_visibility(w,on?1:0);
+	changed();
 	return *this;
 }
 
 bool
 Window::is_supported(Key key) {
+	int k = int(key);
+
+	return k >= 0 && k < nkeys && rkeymap[k];
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return the input sequences the terminal sends for the supported
+// keys (from terminfo, plus any added with define_key())
+//////////////////////////////////////////////////////////////////////
 
-	auto it = rkeymap.find(key);
-	return it != rkeymap.end();
+std::vector<std::pair<std::string,Key>>
+Window::key_bindings() {
+	std::vector<std::pair<std::string,Key>> bindings;
+
+	for ( auto& kp : keylist ) {
+		char *seq;
+
+		for ( int n=0; (seq = keybound(kp.ikey,n)) != nullptr; ++n ) {
+			bindings.emplace_back(seq,kp.key);
+			free(seq);
+		}
+	}
+	return bindings;
 }
 
 // End window.cpp